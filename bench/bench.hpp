@@ -0,0 +1,82 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+// A small benchmark harness for the host build with a fixed output format so runs can be compared
+// (see scripts/compare_bench.py); every benchmark prints one line:
+//    <name> <iterations> <ns per iteration> <checksum>
+// The time is the best of several repetitions, which is far steadier than the mean on a busy machine
+// The checksum is of the first iteration's results, so a change in behaviour shows up as well as a change in speed
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+namespace bench {
+
+// FNV-1a, for folding results into a checksum
+class hasher {
+public:
+   constexpr void add(std::uint32_t value) noexcept
+   {
+      for (int i = 0; i < 4; ++i) {
+         hash ^= (value >> (i * 8)) & 0xFF;
+         hash *= 16'777'619;
+      }
+   }
+
+   constexpr std::uint32_t get() const noexcept { return hash; }
+
+private:
+   std::uint32_t hash = 2'166'136'261;
+};
+
+struct options {
+   // Only benchmarks whose names contain this are run
+   std::string_view filter;
+   int repetitions = 5;
+   // Iterations are doubled until a repetition takes at least this long
+   std::chrono::nanoseconds min_time = std::chrono::milliseconds{5};
+};
+
+inline options global_options;
+
+// Keeps results alive so the optimizer can't drop the work
+inline volatile std::uint32_t sink;
+
+// body() runs one iteration and returns a checksum of what it did
+template<typename Body>
+void run(std::string_view name, Body&& body)
+{
+   if (name.find(global_options.filter) == std::string_view::npos) {
+      return;
+   }
+   using clock = std::chrono::steady_clock;
+   const auto time = [&](long iterations) {
+      const auto start = clock::now();
+      for (long i = 0; i < iterations; ++i) {
+         sink = body();
+      }
+      return clock::now() - start;
+   };
+
+   const auto checksum = body();
+   long iterations = 1;
+   while (time(iterations) < global_options.min_time) {
+      iterations *= 2;
+   }
+   auto best = clock::duration::max();
+   for (int i = 0; i < global_options.repetitions; ++i) {
+      const auto elapsed = time(iterations);
+      if (elapsed < best) {
+         best = elapsed;
+      }
+   }
+   const auto ns = std::chrono::duration<double, std::nano>(best).count() / iterations;
+   std::printf("%-40.*s %10ld %14.1f %08x\n", static_cast<int>(name.size()), name.data(), iterations, ns, checksum);
+   std::fflush(stdout);
+}
+
+} // namespace bench
+
+#endif // BENCH_HPP
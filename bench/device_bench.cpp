@@ -0,0 +1,415 @@
+// On-device benchmarks: times a fixed set of cases with the TM2/TM3 cycle counter under several ROM wait state
+// settings and writes the results to SRAM, where scripts/decode_bench_sram.py can read them from a save file
+// Everything is deterministic (no interrupts, fixed inputs), so runs on the same hardware/emulator are comparable
+//
+// Results block, at SRAM offset 0x6000 (all values little endian):
+//    char magic[4]        'P', 'K', 'B', '1'
+//    u16 num_results      updated after every result so a run that didn't finish can still be read
+//    u16 finished         1 once every case has run
+// Followed by num_results results of 32 bytes each:
+//    char name[20]        NUL padded
+//    u16 waitcnt          the WAITCNT value the case ran with
+//    u16 runs
+//    u32 best             the fewest cycles of any run, less the cost of reading the counter
+//    u32 worst            the most cycles of any run, less the cost of reading the counter
+
+#include "assets.hpp"
+#include "battle_tilemap.hpp"
+#include "common_funcs.hpp"
+#include "crash_screen.hpp"
+#include "gba.hpp"
+#include "gba_bios.hpp"
+#include "huffman.hpp"
+#include "huffman_data.hpp"
+#include "map_data.hpp"
+#include "overlay.hpp"
+#include "pathfinding.hpp"
+#include "perf_run.hpp"
+#include "save_data.hpp"
+#include "save_format.hpp"
+#include "static_vector.hpp"
+
+#include "generated/font_bios.hpp"
+
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string_view>
+
+namespace {
+
+constexpr int results_offset = 0x6000;
+constexpr int result_name_size = 20;
+constexpr int max_results = 128;
+constexpr int results_size = 8 + max_results * 32;
+
+// The block lives in the last file slot, which the SRAM cases never save to
+static_assert(results_offset >= file_slot_offset(num_file_slots - 1));
+static_assert(results_offset + results_size <= save_data_end);
+
+struct result_header {
+   std::array<char, 4> magic;
+   std::uint16_t num_results;
+   std::uint16_t finished;
+};
+static_assert(sizeof(result_header) == 8);
+
+struct result {
+   std::array<char, result_name_size> name;
+   std::uint16_t waitcnt;
+   std::uint16_t runs;
+   std::uint32_t best;
+   std::uint32_t worst;
+};
+static_assert(sizeof(result) == 32);
+
+struct waitcnt_setting {
+   const char* name;
+   std::uint16_t value;
+};
+
+// SRAM stays at 8 wait cycles throughout, as it is in the game
+constexpr std::array<waitcnt_setting, 4> waitcnt_settings{{
+   // What the BIOS leaves it at (apart from SRAM)
+   {"4/2", 0b0000'0000'0000'0011},
+   {"3/1 prefetch", 0b0100'0110'1101'0111},
+   {"2/1", 0b0000'0110'1101'1011},
+   // set_fast_mode
+   {"2/1 prefetch", gba::fast_waitcnt},
+}};
+
+struct bench_case {
+   const char* name;
+   // Has to be loaded for the code being timed
+   overlay_id overlay;
+   void (*run)() noexcept;
+   // Runs untimed before every run, if there is one
+   void (*prepare)() noexcept = nullptr;
+};
+
+constexpr int runs_per_case = 4;
+
+constexpr auto layer_screen_block = gba::bg_opt::screen_base_block::b56;
+
+GBA_EWRAM_BSS std::array<std::uint32_t, 0x1000> copy_source;
+GBA_EWRAM_BSS std::array<std::uint8_t, 0x1000> huffman_output;
+// For the BIOS decompression cases, which decompress the font's tiles (4 KB)
+GBA_EWRAM_BSS std::array<std::uint32_t, 0x400> decompress_output;
+GBA_EWRAM_BSS file_save_data save_data;
+GBA_EWRAM_BSS file_cache save_cache;
+
+// Keeps results alive so the work can't be optimized away
+volatile std::uint32_t sink;
+
+// 16 KB of VRAM nothing else here uses
+volatile std::uint32_t* copy_dest() noexcept { return gba::bg_char_loc(gba::bg_opt::char_base_block::b16); }
+
+std::span<const pos> enemy_positions(const full_map_info& map_info) noexcept
+{
+   static static_vector<pos, max_enemies> positions;
+   positions.clear();
+   for (const auto& enemy : map_info.base_enemies) {
+      if (enemy.level > 0) {
+         positions.push_back({enemy.x, enemy.y});
+      }
+   }
+   return {positions.data(), positions.size()};
+}
+
+// Inputs that can't be folded at compile time, different for each of the 64 iterations of the arithmetic cases
+std::int32_t numerator(int i) noexcept { return static_cast<std::int32_t>(copy_source[i]); }
+std::int32_t denominator(int i) noexcept { return static_cast<std::int32_t>(copy_source[i + 1] & 0xFF) + 1; }
+std::int16_t fixed_x(int i) noexcept { return static_cast<std::int16_t>(copy_source[i]); }
+std::int16_t fixed_y(int i) noexcept { return static_cast<std::int16_t>(copy_source[i] >> 16); }
+
+// A sprite's worth of rotation and scaling for every OBJ parameter group
+constexpr auto obj_affine_sources = [] {
+   std::array<gba::bios::obj_affine_source, 32> sources{};
+   for (int i = 0; i < 32; ++i) {
+      sources[i] = {static_cast<std::int16_t>(0x100 + i * 8), 0x100, static_cast<std::uint16_t>(i * 0x800), 0};
+   }
+   return sources;
+}();
+
+// A background's worth for each of the 4 that could be affine (mode 2 only has 2, but the BIOS doesn't care)
+constexpr std::array<gba::bios::bg_affine_source, 4> bg_affine_sources{{
+   {64 << 8, 64 << 8, 120, 80, 0x100, 0x100, 0x0000},
+   {64 << 8, 64 << 8, 120, 80, 0x180, 0x180, 0x2000},
+   {128 << 8, 32 << 8, 0, 0, 0x080, 0x100, 0x8000},
+   {0, 0, 120, 80, 0x200, 0x200, 0xC000},
+}};
+GBA_EWRAM_BSS std::array<gba::bios::bg_affine_dest, 4> bg_affine_output;
+
+void find_path_from_base(int map, int move) noexcept
+{
+   const auto map_info = get_map_data_and_enemies(0, map);
+   const auto tiles = find_path(map_info.base_x, map_info.base_y, move, max_move, map_info, enemy_positions(map_info));
+   sink = tiles.size();
+}
+
+const std::array cases{
+   bench_case{"find_path cross m5", overlay_id::battle, []() noexcept { find_path_from_base(4, 5); }},
+   bench_case{"find_path arena m7", overlay_id::battle, []() noexcept { find_path_from_base(7, max_move); }},
+   bench_case{"redraw_layer", overlay_id::battle, []() noexcept {
+      redraw_layer(0, 0, get_map_data_and_enemies(0, 4).map->low_priority_tiles, layer_screen_block);
+   }},
+   bench_case{"scroll_layer x", overlay_id::battle, []() noexcept {
+      scroll_layer(8, 0, get_map_data_and_enemies(0, 4).map->low_priority_tiles, layer_screen_block, 8, 0);
+   }},
+   bench_case{"scroll_layer y", overlay_id::battle, []() noexcept {
+      scroll_layer(0, 8, get_map_data_and_enemies(0, 4).map->low_priority_tiles, layer_screen_block, 0, 8);
+   }},
+   // What placing every sprite in the battle costs
+   bench_case{"oam 128 sprites", overlay_id::none, []() noexcept {
+      using namespace gba::obj_opt;
+      for (int i = 0; i < 128; ++i) {
+         gba::obj{i}.set_attr0(gba::obj_attr0_options{}.set(display::enable).set(rot_scale::disable));
+         gba::obj{i}.set_loc(i, i);
+         gba::obj{i}.set_attr2(gba::obj_attr2_options{}.set(priority::p2));
+      }
+   }},
+   bench_case{"sram save full", overlay_id::menus, []() noexcept { sink = save_file(0, save_data, save_cache); },
+      // Forget what's in SRAM so every byte is written
+      []() noexcept { save_cache.file_no = -1; }},
+   bench_case{"sram save changed", overlay_id::menus, []() noexcept { sink = save_file(0, save_data, save_cache); },
+      []() noexcept { save_data.frame_count += 1; }},
+   bench_case{"dma3 copy 16k", overlay_id::none, []() noexcept {
+      gba::dma3_copy(copy_source.data(), copy_source.data() + copy_source.size(), copy_dest());
+   }},
+   bench_case{"cpu copy 16k", overlay_id::none, []() noexcept {
+      const auto dest = copy_dest();
+      for (std::size_t i = 0; i < copy_source.size(); ++i) {
+         dest[i] = copy_source[i];
+      }
+   }},
+   bench_case{"rle title", overlay_id::none, []() noexcept {
+      load_asset(asset_id::title, gba::bg_screen_loc(gba::bg_opt::screen_base_block::b0));
+   }},
+   bench_case{"huffman 4k", overlay_id::none, []() noexcept {
+      decompress(tree, compressed_image, huffman_output.data(), huffman_output.size());
+   }},
+   // gba::bios against the code it could replace (or its software fallback where there isn't any)
+   bench_case{"bios div x64", overlay_id::none, []() noexcept {
+      std::int32_t total = 0;
+      for (int i = 0; i < 64; ++i) {
+         total += gba::bios::div(numerator(i), denominator(i)).quotient;
+      }
+      sink = total;
+   }},
+   bench_case{"libgcc div x64", overlay_id::none, []() noexcept {
+      std::int32_t total = 0;
+      for (int i = 0; i < 64; ++i) {
+         total += numerator(i) / denominator(i);
+      }
+      sink = total;
+   }},
+   bench_case{"bios sqrt x64", overlay_id::none, []() noexcept {
+      std::uint32_t total = 0;
+      for (int i = 0; i < 64; ++i) {
+         total += gba::bios::sqrt(copy_source[i]);
+      }
+      sink = total;
+   }},
+   bench_case{"cpu sqrt x64", overlay_id::none, []() noexcept {
+      std::uint32_t total = 0;
+      for (int i = 0; i < 64; ++i) {
+         total += gba::bios::fallback::sqrt(copy_source[i]);
+      }
+      sink = total;
+   }},
+   bench_case{"bios arctan2 x64", overlay_id::none, []() noexcept {
+      std::uint32_t total = 0;
+      for (int i = 0; i < 64; ++i) {
+         total += gba::bios::arctan2(fixed_x(i), fixed_y(i));
+      }
+      sink = total;
+   }},
+   bench_case{"float atan2 x64", overlay_id::none, []() noexcept {
+      std::uint32_t total = 0;
+      for (int i = 0; i < 64; ++i) {
+         total += gba::bios::fallback::arctan2(fixed_x(i), fixed_y(i));
+      }
+      sink = total;
+   }},
+   bench_case{"cpu_set copy 16k", overlay_id::none, []() noexcept {
+      gba::bios::cpu_copy(copy_source.data(), copy_source.data() + copy_source.size(), copy_dest());
+   }},
+   bench_case{"fast_set copy 16k", overlay_id::none, []() noexcept {
+      gba::bios::cpu_fast_copy(copy_source.data(), copy_source.data() + copy_source.size(), copy_dest());
+   }},
+   bench_case{"fast_set fill 16k", overlay_id::none, []() noexcept {
+      gba::bios::cpu_fast_fill(copy_dest(), copy_dest() + copy_source.size(), 0x1111'1111);
+   }},
+   bench_case{"dma3 fill 16k", overlay_id::none, []() noexcept {
+      gba::dma3_fill(copy_dest(), copy_dest() + copy_source.size(), 0x1111'1111);
+   }},
+   bench_case{"bios rle title", overlay_id::none, []() noexcept {
+      gba::bios::rle_decompress_vram(asset_handle{asset_id::title}.stored_data(),
+         gba::bg_screen_loc(gba::bg_opt::screen_base_block::b0));
+   }},
+   bench_case{"bios lz77 4k", overlay_id::none, []() noexcept {
+      gba::bios::lz77_decompress(font_lz77, decompress_output.data());
+   }},
+   bench_case{"bios lz77 vram 4k", overlay_id::none, []() noexcept {
+      gba::bios::lz77_decompress_vram(font_lz77, reinterpret_cast<volatile std::uint16_t*>(copy_dest()));
+   }},
+   bench_case{"cpu lz77 4k", overlay_id::none, []() noexcept {
+      gba::bios::fallback::lz77_decompress(font_lz77, decompress_output.data());
+   }},
+   bench_case{"bios huffman 4k", overlay_id::none, []() noexcept {
+      gba::bios::huffman_decompress(font_huffman, decompress_output.data());
+   }},
+   bench_case{"cpu huffman 4k", overlay_id::none, []() noexcept {
+      gba::bios::fallback::huffman_decompress(font_huffman, decompress_output.data());
+   }},
+   bench_case{"bios obj_affine x32", overlay_id::none, []() noexcept {
+      gba::bios::obj_affine_set(obj_affine_sources.data(), gba::obj_affine_params_addr(0), 32, 8);
+   }},
+   bench_case{"cpu obj_affine x32", overlay_id::none, []() noexcept {
+      gba::bios::fallback::obj_affine_set(obj_affine_sources.data(), gba::obj_affine_params_addr(0), 32, 8);
+   }},
+   bench_case{"bios bg_affine x4", overlay_id::none, []() noexcept {
+      gba::bios::bg_affine_set(bg_affine_sources.data(), bg_affine_output.data(), 4);
+   }},
+   bench_case{"cpu bg_affine x4", overlay_id::none, []() noexcept {
+      gba::bios::fallback::bg_affine_set(bg_affine_sources.data(), bg_affine_output.data(), 4);
+   }},
+};
+static_assert(std::size(cases) * std::size(waitcnt_settings) <= max_results);
+
+volatile std::uint8_t* results_loc() noexcept { return gba::sram_addr() + results_offset; }
+
+// The cost of reading the counter, which is taken off every measurement
+std::uint32_t counter_overhead() noexcept
+{
+   std::uint32_t overhead = std::numeric_limits<std::uint32_t>::max();
+   for (int i = 0; i < 8; ++i) {
+      const auto start = gba::cycle_count();
+      overhead = std::min(overhead, gba::cycle_count() - start);
+   }
+   return overhead;
+}
+
+result run_case(const bench_case& bench, std::uint16_t waitcnt, std::uint32_t overhead) noexcept
+{
+   load_overlay(bench.overlay);
+   result res{};
+   const std::string_view name{bench.name};
+   std::copy_n(name.begin(), std::min(name.size(), res.name.size()), res.name.begin());
+   res.waitcnt = waitcnt;
+   res.runs = runs_per_case;
+   res.best = std::numeric_limits<std::uint32_t>::max();
+   for (int i = 0; i < runs_per_case; ++i) {
+      if (bench.prepare != nullptr) {
+         bench.prepare();
+      }
+      const auto start = gba::cycle_count();
+      bench.run();
+      const auto cycles = gba::cycle_count() - start - overhead;
+      res.best = std::min(res.best, cycles);
+      res.worst = std::max(res.worst, cycles);
+   }
+   return res;
+}
+
+constexpr auto results_screen_block = gba::bg_opt::screen_base_block::b62;
+constexpr int results_per_page = 16;
+
+void show_results_page(std::span<const result> results, int page) noexcept
+{
+   const auto screen = gba::bg_screen_loc(results_screen_block);
+   gba::dma3_fill(screen, screen + 32 * 32, ' ');
+   write_at(results_screen_block, "Bench done; results in SRAM", 0, 0);
+
+   const auto num_pages = (static_cast<int>(results.size()) + results_per_page - 1) / results_per_page;
+   char buffer[31];
+   auto end = fmt::format_to_n(
+      buffer, std::size(buffer) - 1, "{} ({}/{}, A: next)", waitcnt_settings.back().name, page + 1, num_pages);
+   *end.out = '\0';
+   write_at(results_screen_block, buffer, 0, 1);
+
+   const auto first = page * results_per_page;
+   const auto last = std::min<int>(first + results_per_page, results.size());
+   for (int i = first; i < last; ++i) {
+      end = fmt::format_to_n(buffer,
+         std::size(buffer) - 1,
+         "{: <20}{: >10}",
+         std::string_view{results[i].name.data()},
+         results[i].best);
+      *end.out = '\0';
+      write_at(results_screen_block, buffer, 0, 3 + i - first);
+   }
+}
+
+// Shows the results for the fastest setting a page at a time
+[[noreturn]] void show_results(std::span<const result> results) noexcept
+{
+   static static_vector<result, std::size(cases)> fast_results;
+   for (const auto& res : results) {
+      if (res.waitcnt == waitcnt_settings.back().value) {
+         fast_results.push_back(res);
+      }
+   }
+   const std::span<const result> to_show{fast_results.data(), fast_results.size()};
+
+   load_asset(asset_id::font, gba::bg_char_loc(gba::bg_opt::char_base_block::b0));
+   load_asset(asset_id::font_pal, gba::bg_palette_addr(0));
+   gba::bg0.set_options(gba::bg_options{}.set(results_screen_block).set(gba::bg_opt::char_base_block::b0));
+   gba::bg0.set_scroll(0, 0);
+   int page = 0;
+   show_results_page(to_show, page);
+
+   using namespace gba::lcd_opt;
+   gba::lcd.set_options(gba::lcd_options{}.set(bg_mode::mode_0).set(forced_blank::off).set(display_bg0::on));
+
+   const auto num_pages = (static_cast<int>(to_show.size()) + results_per_page - 1) / results_per_page;
+   gba::keypad_status keypad;
+   while (true) {
+      while (!gba::in_vblank()) {}
+      keypad.update();
+      if (keypad.a_pressed()) {
+         page = (page + 1) % num_pages;
+         show_results_page(to_show, page);
+      }
+      while (gba::in_vblank()) {}
+   }
+}
+
+} // anonymous namespace
+
+int main()
+{
+   crash_screen::install();
+   // The display is off while the cases run; it only gets in the way of the VRAM cases
+   gba::lcd.set_options(gba::lcd_options{}.set(gba::lcd_opt::forced_blank::on));
+   gba::start_cycle_counter();
+   for (std::size_t i = 0; i < copy_source.size(); ++i) {
+      copy_source[i] = i * 0x0101'0101;
+   }
+
+   sram_write(result_header{{'P', 'K', 'B', '1'}, 0, 0}, results_loc());
+   const auto overhead = counter_overhead();
+   static static_vector<result, max_results> results;
+   for (const auto& setting : waitcnt_settings) {
+      gba::set_waitcnt(setting.value);
+      for (const auto& bench : cases) {
+         results.push_back(run_case(bench, setting.value, overhead));
+         sram_write(results.back(), results_loc() + sizeof(result_header) + (results.size() - 1) * sizeof(result));
+         sram_write(static_cast<std::uint16_t>(results.size()), results_loc() + offsetof(result_header, num_results));
+      }
+   }
+   sram_write(std::uint16_t{1}, results_loc() + offsetof(result_header, finished));
+#ifdef PEKMUN2_PERF_RUN
+   // The perf check reads the results from the save
+   perf_run::finish();
+#endif
+
+   gba::set_fast_mode();
+   show_results(results);
+}
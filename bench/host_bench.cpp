@@ -0,0 +1,265 @@
+// Benchmarks of the game's hot kernels, run natively against the host backend of gba.hpp
+// Usage: host_bench [filter]
+// Only benchmarks whose names contain the filter are run; see bench.hpp for the output format
+
+#include "bench.hpp"
+
+#include "battle_tilemap.hpp"
+#include "classes.hpp"
+#include "data.hpp"
+#include "huffman.hpp"
+#include "huffman_data.hpp"
+#include "map_data.hpp"
+#include "pathfinding.hpp"
+#include "prng.hpp"
+#include "static_vector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A plain sum, since hashing every word would cost about as much as some of the kernels
+std::uint32_t sum_words(const volatile std::uint16_t* start, int count) noexcept
+{
+   std::uint32_t sum = 0;
+   for (int i = 0; i < count; ++i) {
+      sum = sum * 31 + start[i];
+   }
+   return sum;
+}
+
+// With room for one more, which bench_find_path uses for the players' starting square
+static_vector<pos, max_enemies + 1> enemy_positions(const full_map_info& map_info) noexcept
+{
+   static_vector<pos, max_enemies + 1> positions;
+   for (const auto& enemy : map_info.base_enemies) {
+      if (enemy.level > 0) {
+         positions.push_back({enemy.x, enemy.y});
+      }
+   }
+   return positions;
+}
+
+// Every shipped map with each move value, searching with every jump that can matter from where the battle searches:
+// the players' starting square and each enemy's square (with the enemies in the way)
+void bench_find_path()
+{
+   for (int map = 0; map < maps_per_chapter * num_chapters; ++map) {
+      const auto map_info = get_map_data_and_enemies(map / maps_per_chapter, map % maps_per_chapter);
+      const auto& map_data = *map_info.map;
+      const auto enemies = enemy_positions(map_info);
+      auto starts = enemies;
+      starts.push_back({map_info.base_x, map_info.base_y});
+      int max_height = 0;
+      for (int y = 0; y < map_data.height; ++y) {
+         for (int x = 0; x < map_data.width; ++x) {
+            max_height = std::max<int>(max_height, map_data.height_at(x, y));
+         }
+      }
+      for (int move = 1; move <= max_move; ++move) {
+         const auto name = "find_path/map" + std::to_string(map + 1) + "/move" + std::to_string(move);
+         bench::run(name, [&] {
+            bench::hasher hash;
+            for (int jump = 0; jump <= max_height; ++jump) {
+               for (const auto& start : starts) {
+                  const auto tiles = find_path(start.x, start.y, move, jump, map_info, enemies);
+                  hash.add(tiles.size());
+                  hash.add((tiles.back().x << 8) | static_cast<std::uint8_t>(tiles.back().y));
+               }
+            }
+            return hash.get();
+         });
+      }
+   }
+}
+
+void bench_static_vector()
+{
+   using vector = static_vector<pos, num_squares>;
+   const auto make_pos = [](int i) { return pos{static_cast<std::int8_t>(i % 16), static_cast<std::int8_t>(i / 16)}; };
+
+   bench::run("static_vector/push_back", [&] {
+      vector positions;
+      for (int i = 0; i < num_squares; ++i) {
+         positions.push_back(make_pos(i));
+      }
+      return static_cast<std::uint32_t>(positions.size() + positions.back().x);
+   });
+
+   // How the battle drops occupied squares from the move tiles
+   bench::run("static_vector/erase_middle", [&] {
+      vector positions;
+      for (int i = 0; i < num_squares; ++i) {
+         positions.push_back(make_pos(i));
+      }
+      bench::hasher hash;
+      while (!positions.empty()) {
+         const auto middle = positions.begin() + positions.size() / 2;
+         hash.add(middle->x + middle->y * 16);
+         positions.erase(middle);
+      }
+      return hash.get();
+   });
+
+   vector full;
+   for (int i = 0; i < num_squares; ++i) {
+      full.push_back(make_pos(i));
+   }
+   bench::run("static_vector/copy", [&] {
+      const vector copy{full};
+      return static_cast<std::uint32_t>(copy.size() + copy[num_squares / 2].x);
+   });
+}
+
+void bench_stats()
+{
+   constexpr int num_classes = std::size(class_data);
+   constexpr int max_level = 99;
+
+   bench::run("character/calc_stats", [] {
+      prng rng{12345};
+      bench::hasher hash;
+      for (int class_ = 1; class_ < num_classes; ++class_) {
+         character unit{};
+         unit.bases = class_data[class_].stats;
+         for (int level = 1; level <= max_level; ++level) {
+            unit.level = level;
+            unit.calc_stats(&rng);
+            hash.add(unit.attack);
+            hash.add(unit.max_hp);
+         }
+      }
+      return hash.get();
+   });
+
+   bench::run("character/level_up_if_needed", [] {
+      bench::hasher hash;
+      for (int class_ = 1; class_ < num_classes; ++class_) {
+         character unit{};
+         unit.bases = class_data[class_].stats;
+         unit.level = 1;
+         unit.calc_stats(nullptr);
+         // A handful of big experience gains, each worth several levels
+         for (int i = 0; i < 8; ++i) {
+            unit.exp += 2000;
+            unit.level_up_if_needed();
+            hash.add(unit.level);
+            hash.add(unit.defense);
+         }
+      }
+      return hash.get();
+   });
+
+   std::vector<character> units;
+   for (int class_ = 1; class_ < num_classes; ++class_) {
+      for (int level = 1; level <= max_level; level += 4) {
+         auto& unit = units.emplace_back();
+         unit.bases = class_data[class_].stats;
+         unit.level = level;
+         unit.calc_stats(nullptr);
+      }
+   }
+   bench::run("character/calc_normal_damage", [&] {
+      std::uint32_t total = 0;
+      for (const auto& attacker : units) {
+         for (const auto& defender : units) {
+            total += calc_normal_damage(attacker, defender);
+         }
+      }
+      return total;
+   });
+}
+
+void bench_huffman()
+{
+   static std::array<std::uint8_t, 76800> image;
+   bench::run("huffman/decompress", [] {
+      decompress(tree, compressed_image, image.data(), image.size());
+      std::uint32_t sum = 0;
+      for (const auto byte : image) {
+         sum += byte;
+      }
+      return sum;
+   });
+}
+
+void bench_tilemap()
+{
+   // One of each map layout
+   const std::array<std::pair<const char*, int>, 4> layouts{{
+      {"test_map", 0},
+      {"test_layers", 1},
+      {"cross", 4},
+      {"arena", 7},
+   }};
+   static tilemap_buffer low_priority_buffer;
+   static tilemap_buffer high_priority_buffer;
+   for (const auto& [layout_name, map] : layouts) {
+      const auto map_info = get_map_data_and_enemies(0, map);
+      const auto& map_data = *map_info.map;
+      const auto enemies = enemy_positions(map_info);
+      const auto move_tiles = find_path(map_info.base_x, map_info.base_y, 5, 5, map_info, enemies);
+      const auto attack_tiles = find_path(map_info.base_x, map_info.base_y, 1, max_move, map_info, {});
+      const std::string prefix = std::string{"tilemap/"} + layout_name;
+
+      bench::run(prefix + "/move_buffers", [&] {
+         std::fill(low_priority_buffer.begin(), low_priority_buffer.end(), blank_tile);
+         std::fill(high_priority_buffer.begin(), high_priority_buffer.end(), blank_tile);
+         fill_move_buffers(map_info, 2, move_tiles, low_priority_buffer, high_priority_buffer);
+         fill_move_buffers(map_info, 3, attack_tiles, low_priority_buffer, high_priority_buffer);
+         return sum_words(low_priority_buffer.data(), low_priority_buffer.size())
+              ^ sum_words(high_priority_buffer.data(), high_priority_buffer.size());
+      });
+
+      bench::run(prefix + "/redraw", [&] {
+         redraw_layer(0, 0, high_priority_buffer.data(), bg0_screen_block);
+         redraw_layer(0, 0, low_priority_buffer.data(), bg1_screen_block);
+         redraw_layer(0, 0, map_data.high_priority_tiles, bg2_screen_block);
+         redraw_layer(0, 0, map_data.low_priority_tiles, bg3_screen_block);
+         return sum_words(gba::bg_screen_loc(bg3_screen_block), 4 * 32 * 32);
+      });
+
+      // Pans right, down, left and up across the map a tile at a time, as holding the d-pad does
+      bench::run(prefix + "/scroll", [&] {
+         constexpr std::array<std::pair<int, int>, 4> directions{{{8, 0}, {0, 8}, {-8, 0}, {0, -8}}};
+         int camera_x = 0;
+         int camera_y = 0;
+         for (const auto& [delta_x, delta_y] : directions) {
+            for (int step = 0; step < 16; ++step) {
+               camera_x += delta_x;
+               camera_y += delta_y;
+               scroll_layer(camera_x, camera_y, high_priority_buffer.data(), bg0_screen_block, delta_x, delta_y);
+               scroll_layer(camera_x, camera_y, low_priority_buffer.data(), bg1_screen_block, delta_x, delta_y);
+               scroll_layer(camera_x, camera_y, map_data.high_priority_tiles, bg2_screen_block, delta_x, delta_y);
+               scroll_layer(camera_x, camera_y, map_data.low_priority_tiles, bg3_screen_block, delta_x, delta_y);
+            }
+         }
+         return sum_words(gba::bg_screen_loc(bg3_screen_block), 4 * 32 * 32);
+      });
+   }
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+   if (argc > 1) {
+      bench::global_options.filter = argv[1];
+   }
+#ifdef NDEBUG
+   std::printf("# pekmun2 host benchmarks (release build)\n");
+#else
+   std::printf("# pekmun2 host benchmarks (debug build; timings aren't representative)\n");
+#endif
+   std::printf("# %-38s %10s %14s %8s\n", "name", "iterations", "ns/iteration", "checksum");
+   bench_find_path();
+   bench_static_vector();
+   bench_stats();
+   bench_huffman();
+   bench_tilemap();
+}
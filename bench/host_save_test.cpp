@@ -0,0 +1,306 @@
+// Checks of the save format, run natively against the host backend of gba.hpp, where SRAM is an ordinary array
+// Usage: host_save_test
+// Prints each check that fails and exits with 1 if any did (ctest runs it, see CMakeLists.txt)
+
+#include "crc16.hpp"
+#include "save_data.hpp"
+#include "save_format.hpp"
+#include "stat_math.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <tuple>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* test, const char* what) noexcept
+{
+   if (!ok) {
+      std::printf("FAIL %s: %s\n", test, what);
+      ++failures;
+   }
+}
+
+auto fields(const item& item_) noexcept
+{
+   return std::tie(
+      item_.exists,
+      item_.item_name,
+      item_.move,
+      item_.jump,
+      item_.hp,
+      item_.mp,
+      item_.attack,
+      item_.defense,
+      item_.m_attack,
+      item_.m_defense,
+      item_.speed,
+      item_.hit);
+}
+
+auto fields(const base_stats& bases) noexcept
+{
+   return std::tie(
+      bases.hp,
+      bases.mp,
+      bases.attack,
+      bases.defense,
+      bases.m_attack,
+      bases.m_defense,
+      bases.speed,
+      bases.hit,
+      bases.move,
+      bases.jump);
+}
+
+bool same(const item& lhs, const item& rhs) noexcept { return fields(lhs) == fields(rhs); }
+
+bool same(const character& lhs, const character& rhs) noexcept
+{
+   const auto stats = [](const character& char_) {
+      return std::tie(
+         char_.exists,
+         char_.deployed,
+         char_.class_,
+         char_.name,
+         char_.level,
+         char_.hp,
+         char_.max_hp,
+         char_.mp,
+         char_.max_mp,
+         char_.hp_mp_shift,
+         char_.attack,
+         char_.defense,
+         char_.m_attack,
+         char_.m_defense,
+         char_.speed,
+         char_.hit,
+         char_.exp);
+   };
+   if (stats(lhs) != stats(rhs) || fields(lhs.bases) != fields(rhs.bases)) {
+      return false;
+   }
+   for (int i = 0; i < 4; ++i) {
+      if (!same(lhs.equips[i], rhs.equips[i])) {
+         return false;
+      }
+   }
+   return true;
+}
+
+bool same(const file_save_data& lhs, const file_save_data& rhs) noexcept
+{
+   const auto header = [](const file_save_data& data) {
+      return std::tie(
+         data.game_completed,
+         data.enemy_strength,
+         data.chapter,
+         data.chapter_progress,
+         data.file_name,
+         data.file_level,
+         data.frame_count,
+         data.money);
+   };
+   if (header(lhs) != header(rhs)) {
+      return false;
+   }
+   for (int i = 0; i < max_characters; ++i) {
+      if (!same(lhs.characters[i], rhs.characters[i])) {
+         return false;
+      }
+   }
+   for (int i = 0; i < max_items; ++i) {
+      if (!same(lhs.items[i], rhs.items[i])) {
+         return false;
+      }
+   }
+   return true;
+}
+
+template<std::size_t N>
+void set_name(std::array<char, N>& name, const char* text) noexcept
+{
+   name.fill('\0');
+   std::strncpy(name.data(), text, N);
+}
+
+// Alternates between the extremes so every varint is as long as it gets
+item full_item(int n) noexcept
+{
+   const auto stat = n % 2 == 0 ? stat_max : stat_min;
+   return {true, static_cast<std::uint8_t>(n), -1, 127, stat, stat, stat, stat, stat, stat, stat, stat};
+}
+
+// Every character, with the items split between equipment and the inventory
+file_save_data full_file() noexcept
+{
+   file_save_data data{};
+   data.game_completed = true;
+   data.enemy_strength = std::numeric_limits<std::uint16_t>::max();
+   data.chapter = 0xFF;
+   data.chapter_progress = 0xFF;
+   set_name(data.file_name, "ABCDEFGHIJKLMNOP");
+   data.file_level = stat_min;
+   data.frame_count = std::numeric_limits<std::uint64_t>::max();
+   data.money = std::numeric_limits<std::uint64_t>::max();
+   int items_left = max_items;
+   for (int i = 0; i < max_characters; ++i) {
+      auto& char_ = data.characters[i];
+      char_.exists = true;
+      char_.deployed = i % 2 == 0;
+      char_.class_ = i;
+      char_.bases = {255, 254, 253, 252, 251, 250, 249, 248, -128, 127};
+      set_name(char_.name, "0123456789abcdef");
+      const auto stat = i % 2 == 0 ? stat_max : stat_min;
+      for (auto value : {&char_.level, &char_.hp, &char_.max_hp, &char_.mp, &char_.max_mp, &char_.attack,
+                         &char_.defense, &char_.m_attack, &char_.m_defense, &char_.speed, &char_.hit, &char_.exp}) {
+         *value = stat;
+      }
+      char_.hp_mp_shift = 31;
+      // Every other slot, so both states of each equipment bit are covered
+      for (int j = i % 2; j < 4 && items_left > max_items / 2; j += 2) {
+         char_.equips[j] = full_item(items_left);
+         --items_left;
+      }
+   }
+   // Half the items are equipped, so the rest fit in every other inventory slot
+   for (int i = 0; i < items_left; ++i) {
+      data.items[i * 2] = full_item(i);
+   }
+   return data;
+}
+
+// A new game's worth: a few characters and no items
+file_save_data small_file() noexcept
+{
+   file_save_data data{};
+   set_name(data.file_name, "Small");
+   data.file_level = 3;
+   data.frame_count = 12'345;
+   for (const int i : {0, 5}) {
+      auto& char_ = data.characters[i];
+      char_.exists = true;
+      char_.class_ = 1;
+      char_.bases = {10, 5, 8, 7, 6, 5, 9, 90, 4, 2};
+      set_name(char_.name, "Pek");
+      char_.level = 3;
+      char_.calc_stats(nullptr);
+      char_.fully_heal();
+   }
+   return data;
+}
+
+void test_round_trip(const char* test, const file_save_data& data) noexcept
+{
+   gba::host::reset();
+   auto cache = std::make_unique<file_cache>();
+   check(count_items(data) <= max_items, test, "file has too many items");
+   check(save_file(1, data, *cache) > 0, test, "save_file failed");
+
+   auto fresh_cache = std::make_unique<file_cache>();
+   auto loaded = std::make_unique<file_save_data>();
+   check(load_file(1, *loaded, *fresh_cache), test, "load_file failed");
+   check(same(data, *loaded), test, "loaded file differs from the saved one");
+
+   const auto summary = read_file_directory()[1];
+   check(summary.exists && summary.sequence == 1, test, "directory has no summary for the file");
+   check(summary.frame_count == data.frame_count && summary.chapter == data.chapter, test, "summary differs");
+}
+
+void corrupt(volatile std::uint8_t* loc) noexcept { *loc = *loc ^ 0x40; }
+
+// A bad CRC on the newest bank falls back to the one before; with both bad there's no file
+void test_corruption_fallback() noexcept
+{
+   constexpr auto test = "corruption_fallback";
+   gba::host::reset();
+   auto cache = std::make_unique<file_cache>();
+   auto data = std::make_unique<file_save_data>(small_file());
+   save_file(2, *data, *cache);
+   const auto first_bank = cache->active_bank;
+   data->frame_count += 100;
+   save_file(2, *data, *cache);
+   const auto second_bank = cache->active_bank;
+   check(first_bank != second_bank, test, "saves went to the same bank");
+
+   corrupt(file_bank_loc(2, second_bank) + file_header_size + 1);
+   auto loaded = std::make_unique<file_save_data>();
+   auto fresh_cache = std::make_unique<file_cache>();
+   check(load_file(2, *loaded, *fresh_cache), test, "no fallback to the older bank");
+   check(fresh_cache->active_bank == first_bank, test, "wrong bank loaded");
+   check(loaded->frame_count == data->frame_count - 100, test, "older bank's data not loaded");
+
+   corrupt(file_bank_loc(2, first_bank) + file_header_size + 1);
+   fresh_cache = std::make_unique<file_cache>();
+   check(!load_file(2, *loaded, *fresh_cache), test, "corrupt file loaded");
+}
+
+// A bank whose CRC matches but whose payload is cut short isn't loaded, and the caller's data is left alone
+void test_bad_payload() noexcept
+{
+   constexpr auto test = "bad_payload";
+   gba::host::reset();
+   auto cache = std::make_unique<file_cache>();
+   save_file(3, small_file(), *cache);
+
+   // Cut the payload down to 2 bytes, with a CRC to match
+   constexpr int payload_size = 2;
+   const auto loc = file_bank_loc(3, cache->active_bank);
+   loc[7] = payload_size;
+   loc[8] = 0;
+   std::array<std::uint8_t, file_header_size + payload_size> bytes;
+   sram_read_bytes(bytes, loc);
+   const auto crc = crc16(std::span{bytes}.subspan(6));
+   loc[4] = crc & 0xFF;
+   loc[5] = crc >> 8;
+
+   auto data = std::make_unique<file_save_data>(full_file());
+   auto fresh_cache = std::make_unique<file_cache>();
+   check(!load_file(3, *data, *fresh_cache), test, "truncated file loaded");
+   check(same(*data, full_file()), test, "failed load changed the caller's data");
+}
+
+// With both banks holding a file, saves after a load or to a file that isn't cached only write what changed
+void test_delta_saves() noexcept
+{
+   constexpr auto test = "delta_saves";
+   gba::host::reset();
+   auto data = std::make_unique<file_save_data>(small_file());
+   auto cache = std::make_unique<file_cache>();
+   save_file(0, *data, *cache);
+   save_file(0, *data, *cache);
+
+   // The sequence number and CRC change on every save; the frame count is the only other change
+   constexpr int max_delta = 8;
+   auto fresh_cache = std::make_unique<file_cache>();
+   check(load_file(0, *data, *fresh_cache), test, "load_file failed");
+   for (int i = 0; i < 2; ++i) {
+      data->frame_count += 1;
+      const auto bytes_written = save_file(0, *data, *fresh_cache);
+      check(bytes_written > 0 && bytes_written <= max_delta, test, "save after a load rewrote the file");
+   }
+
+   fresh_cache = std::make_unique<file_cache>();
+   data->frame_count += 1;
+   const auto bytes_written = save_file(0, *data, *fresh_cache);
+   check(bytes_written > 0 && bytes_written <= max_delta, test, "save with a cold cache rewrote the file");
+}
+
+} // anonymous namespace
+
+int main()
+{
+   test_round_trip("round_trip/small", small_file());
+   test_round_trip("round_trip/full", full_file());
+   test_corruption_fallback();
+   test_bad_payload();
+   test_delta_saves();
+   if (failures == 0) {
+      std::printf("All save format checks passed\n");
+   }
+   return failures == 0 ? 0 : 1;
+}
@@ -149,8 +149,10 @@ int main()
    };
 
    const auto map = [&]() {
-      constexpr auto high_priority = adjust_tile_array(std::span{test_map_high_priority_tiles}, tileset_base, 1);
-      constexpr auto low_priority = adjust_tile_array(std::span{test_map_low_priority_tiles}, tileset_base, 1);
+      // The map is already rebased to the tileset when it's built
+      static_assert(test_map_tile_offset == tileset_base && test_map_palette == 1);
+      const auto high_priority = std::span{test_map_high_priority_tiles};
+      const auto low_priority = std::span{test_map_low_priority_tiles};
       int camera_target_x = -screen_width / 2;
       int camera_target_y = -screen_height / 2 + test_map.y_offset * 8;
       int camera_x = camera_target_x;
@@ -0,0 +1,103 @@
+# Shared output code for the asset scripts
+#
+# Rather than writing the data out as a giant brace-initialized array (which every
+# file that includes it has to parse) each array is written to a raw .bin file.
+# A small assembly file pulls those into .rodata with .incbin and the header only
+# declares the symbols and their sizes.
+# A JSON manifest listing the blobs is also written so they can be packed into the
+# asset archive (see pack_assets.py).
+
+import json
+import os
+import struct
+
+# Maps the C++ type of an array to its struct format character
+TYPE_FORMATS = {
+   'bool': '?',
+   'std::uint8_t': 'B',
+   'std::uint16_t': 'H',
+   'std::uint32_t': 'I',
+}
+
+class Blob:
+   def __init__(self, name: str, cpp_type: str, values: list[int | bool]):
+      assert cpp_type in TYPE_FORMATS
+      self.name = name
+      self.cpp_type = cpp_type
+      self.values = values
+
+   def to_bytes(self) -> bytes:
+      # The GBA is little endian
+      return struct.pack(f'<{len(self.values)}{TYPE_FORMATS[self.cpp_type]}', *self.values)
+
+def symbol_name(blob: Blob, namespace: str | None) -> str:
+   if namespace is None:
+      return blob.name
+   return f'{namespace}_{blob.name}'
+
+def blob_path(header_path: str, blob: Blob) -> str:
+   return f'{os.path.splitext(header_path)[0]}.{blob.name}.bin'
+
+def asm_path(header_path: str) -> str:
+   return f'{os.path.splitext(header_path)[0]}.s'
+
+def manifest_path(header_path: str) -> str:
+   return f'{os.path.splitext(header_path)[0]}.json'
+
+# Writes out the header, the assembly file, the manifest and one .bin file per blob
+# The assembly file and manifest are written next to the header with .s/.json extensions
+# extra_includes/extra_code are added to the header after the declarations
+def write_asset(
+   header_path: str,
+   header_guard: str,
+   blobs: list[Blob],
+   namespace: str | None = None,
+   extra_includes: list[str] = [],
+   extra_code: str = ''
+):
+   for blob in blobs:
+      with open(blob_path(header_path, blob), 'wb') as f:
+         f.write(blob.to_bytes())
+
+   with open(manifest_path(header_path), 'w') as f:
+      json.dump([{
+         'symbol': symbol_name(blob, namespace),
+         'type': blob.cpp_type,
+         'count': len(blob.values),
+         'path': os.path.abspath(blob_path(header_path, blob))
+      } for blob in blobs], f, indent=3)
+
+   with open(asm_path(header_path), 'w') as f:
+      f.write('   .section .rodata\n')
+      for blob in blobs:
+         symbol = symbol_name(blob, namespace)
+         size = len(blob.to_bytes())
+         f.write(
+            f'   .global {symbol}\n'
+            f'   .type {symbol}, STT_OBJECT\n'
+            f'   .size {symbol}, {size}\n'
+            f'   .balign 4\n'
+            f'{symbol}:\n'
+            f'   .incbin "{os.path.abspath(blob_path(header_path, blob))}"\n'
+         )
+      # Data only, so no executable stack is needed (this is for host builds; GBA binaries don't care)
+      f.write('   .section .note.GNU-stack,"",%progbits\n')
+
+   with open(header_path, 'w') as f:
+      f.write(
+         f'#ifndef {header_guard}\n'
+         f'#define {header_guard}\n'
+         f'#include <cstdint>\n'
+      )
+      for include in extra_includes:
+         f.write(f'#include {include}\n')
+      if namespace is not None:
+         f.write(f'namespace {namespace} {{\n')
+      for blob in blobs:
+         f.write(
+            f'extern const {blob.cpp_type} {blob.name}[{len(blob.values)}] asm("{symbol_name(blob, namespace)}");\n'
+         )
+      if namespace is not None:
+         f.write(f'}}\n')
+      f.write(extra_code)
+      f.write(f'#endif\n')
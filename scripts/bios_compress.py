@@ -0,0 +1,176 @@
+# Compresses a blob from an asset library (see asset_blob.py) in the BIOS LZ77 and Huffman formats, for
+# gba::bios's decompression calls (see src/gba_bios.hpp) and the device bench that times them
+# RLE is in pack_assets.py, which the asset archive uses
+#
+# Writes <symbol>_lz77 and <symbol>_huffman as u32 arrays, each starting with the BIOS header
+# (decompressed size << 8 | type); the LZ77 data never copies from 1 byte back, so the VRAM version can
+# decompress it too, and the Huffman data is in 4-bit units (one per pixel of 4bpp tiles)
+#
+# Usage:
+#    bios_compress.py manifest symbol output_header
+#       manifest is the .json an asset library wrote and symbol the blob in it to compress
+
+import heapq
+import json
+import os
+import struct
+import sys
+
+from asset_blob import Blob, write_asset
+
+LZ77_TYPE = 0x10
+HUFFMAN_TYPE = 0x20
+
+LZ77_MIN_LENGTH = 3
+LZ77_MAX_LENGTH = 18
+# 1 byte back would read the half of a 16-bit unit the VRAM version hasn't written yet
+LZ77_MIN_DISTANCE = 2
+LZ77_MAX_DISTANCE = 0x1000
+# How many earlier matches for the same 3 bytes are tried; plenty for tile data
+LZ77_MAX_CANDIDATES = 64
+
+def bios_header(size: int, type_: int) -> bytes:
+   assert size < (1 << 24)
+   return struct.pack('<I', (size << 8) | type_)
+
+def longest_match(data: bytes, pos: int, candidates: list[int]) -> tuple[int, int]:
+   best_length = 0
+   best_distance = 0
+   max_length = min(LZ77_MAX_LENGTH, len(data) - pos)
+   for start in reversed(candidates[-LZ77_MAX_CANDIDATES:]):
+      distance = pos - start
+      if distance > LZ77_MAX_DISTANCE:
+         break
+      if distance < LZ77_MIN_DISTANCE:
+         continue
+      length = 0
+      while length < max_length and data[start + length] == data[pos + length]:
+         length += 1
+      if length > best_length:
+         best_length = length
+         best_distance = distance
+         if length == max_length:
+            break
+   return best_length, best_distance
+
+# Greedy: takes the longest match at each position
+def lz77_compress(data: bytes) -> bytes:
+   output = bytearray(bios_header(len(data), LZ77_TYPE))
+   positions = {}
+   pos = 0
+   while pos < len(data):
+      flags_at = len(output)
+      output.append(0)
+      for bit in range(8):
+         if pos >= len(data):
+            break
+         key = data[pos:pos + LZ77_MIN_LENGTH]
+         length, distance = longest_match(data, pos, positions.get(key, []))
+         if length >= LZ77_MIN_LENGTH:
+            output[flags_at] |= 0x80 >> bit
+            output.append(((length - LZ77_MIN_LENGTH) << 4) | ((distance - 1) >> 8))
+            output.append((distance - 1) & 0xFF)
+         else:
+            length = 1
+            output.append(data[pos])
+         for i in range(pos, pos + length):
+            positions.setdefault(data[i:i + LZ77_MIN_LENGTH], []).append(i)
+         pos += length
+   return bytes(output)
+
+# Returns the code (as a string of bits) for each nibble value used
+def huffman_codes(counts: dict[int, int]) -> tuple[dict[int, str], object]:
+   # Heap entries are (count, tie breaker, tree), where a tree is a value or a (0 child, 1 child) pair
+   heap = [(count, value, value) for value, count in counts.items()]
+   # A tree needs two leaves
+   if len(heap) == 1:
+      heap.append((0, (heap[0][1] + 1) % 16, (heap[0][1] + 1) % 16))
+   heapq.heapify(heap)
+   tie_breaker = 16
+   while len(heap) > 1:
+      count0, _, tree0 = heapq.heappop(heap)
+      count1, _, tree1 = heapq.heappop(heap)
+      heapq.heappush(heap, (count0 + count1, tie_breaker, (tree0, tree1)))
+      tie_breaker += 1
+   root = heap[0][2]
+
+   codes = {}
+   def walk(tree, code):
+      if isinstance(tree, tuple):
+         walk(tree[0], code + '0')
+         walk(tree[1], code + '1')
+      else:
+         codes[tree] = code
+   walk(root, '')
+   return codes, root
+
+# The tree table: a size byte, the root node, then a pair of children for every node, laid out breadth first
+# A node's bits 0-5 are the offset from its own pair to its children's pair, less 1 (the root counts as pair 0);
+# bits 7 and 6 are set when the 0 and 1 child are values rather than nodes
+# With at most 16 values there are at most 15 pairs, so the offsets always fit
+def huffman_tree_table(root) -> bytes:
+   table = bytearray(2)
+   queue = [(root, 1)]
+   for node, loc in queue:
+      pair_loc = len(table)
+      table += bytes(2)
+      flags = 0
+      for i, child in enumerate(node):
+         if isinstance(child, tuple):
+            queue.append((child, pair_loc + i))
+         else:
+            table[pair_loc + i] = child
+            flags |= 0x80 >> i
+      table[loc] = ((pair_loc - (loc & ~1)) // 2 - 1) | flags
+   # The bits start on a word boundary (the table follows the 4-byte header)
+   while len(table) % 4 != 0:
+      table += bytes(2)
+   table[0] = len(table) // 2 - 1
+   return bytes(table)
+
+def huffman_compress(data: bytes) -> bytes:
+   # The low nibble of each byte comes first
+   nibbles = [n for byte in data for n in (byte & 0xF, byte >> 4)]
+   counts = {}
+   for n in nibbles:
+      counts[n] = counts.get(n, 0) + 1
+   codes, root = huffman_codes(counts)
+   if not isinstance(root, tuple):
+      sys.exit('Huffman tree has no nodes')
+
+   bits = ''.join(codes[n] for n in nibbles)
+   bits += '0' * (-len(bits) % 32)
+   # Each word is read top bit first
+   words = b''.join(struct.pack('<I', int(bits[i:i + 32], 2)) for i in range(0, len(bits), 32))
+   return bios_header(len(data), HUFFMAN_TYPE | 4) + huffman_tree_table(root) + words
+
+def to_words(data: bytes) -> list[int]:
+   data += bytes(-len(data) % 4)
+   return list(struct.unpack(f'<{len(data) // 4}I', data))
+
+def main():
+   if len(sys.argv) != 4:
+      sys.exit(f'Usage: {sys.argv[0]} manifest symbol output_header')
+   with open(sys.argv[1]) as f:
+      blobs = {blob['symbol']: blob for blob in json.load(f)}
+   symbol = sys.argv[2]
+   if symbol not in blobs:
+      sys.exit(f'{sys.argv[1]} has no blob {symbol}')
+   with open(blobs[symbol]['path'], 'rb') as f:
+      data = f.read()
+   # The BIOS writes Huffman data 32 bits at a time
+   assert len(data) % 4 == 0
+
+   output_header = sys.argv[3]
+   name = os.path.splitext(os.path.basename(output_header))[0]
+   write_asset(
+      output_header,
+      f'{name.upper()}_DATA',
+      [
+         Blob(f'{symbol}_lz77', 'std::uint32_t', to_words(lz77_compress(data))),
+         Blob(f'{symbol}_huffman', 'std::uint32_t', to_words(huffman_compress(data))),
+      ]
+   )
+
+if __name__ == "__main__":
+   main()
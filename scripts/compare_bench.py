@@ -0,0 +1,54 @@
+# Compares two runs of the host benchmarks (bench/host_bench.cpp)
+#
+# Prints the change in time for every benchmark in both runs and exits with an error if any got slower by more
+# than the threshold or if any checksum changed (which means the kernel's results changed, not just its speed)
+#
+# Usage:
+#    compare_bench.py baseline.txt current.txt [threshold_percent]
+#       threshold_percent defaults to 10
+
+import sys
+
+
+def read_results(path):
+   results = {}
+   with open(path) as f:
+      for line in f:
+         if line.startswith('#') or not line.strip():
+            continue
+         name, iterations, ns, checksum = line.split()
+         results[name] = (float(ns), checksum)
+   return results
+
+
+def main():
+   if len(sys.argv) not in (3, 4):
+      sys.exit(f'Usage: {sys.argv[0]} baseline.txt current.txt [threshold_percent]')
+   baseline = read_results(sys.argv[1])
+   current = read_results(sys.argv[2])
+   threshold = float(sys.argv[3]) if len(sys.argv) == 4 else 10.0
+
+   failures = 0
+   for name, (ns, checksum) in current.items():
+      if name not in baseline:
+         print(f'{name:<40} new')
+         continue
+      base_ns, base_checksum = baseline[name]
+      change = (ns - base_ns) / base_ns * 100 if base_ns > 0 else 0.0
+      notes = []
+      if change > threshold:
+         notes.append('SLOWER')
+      if checksum != base_checksum:
+         notes.append(f'CHECKSUM {base_checksum} -> {checksum}')
+      if notes:
+         failures += 1
+      print(f'{name:<40} {base_ns:>14.1f} {ns:>14.1f} {change:>+7.1f}% {" ".join(notes)}')
+   for name in baseline.keys() - current.keys():
+      print(f'{name:<40} missing')
+
+   if failures:
+      sys.exit(f'{failures} benchmark(s) regressed')
+
+
+if __name__ == "__main__":
+   main()
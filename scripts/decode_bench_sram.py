@@ -0,0 +1,47 @@
+# Prints the results the on-device benchmarks (bench/device_bench.cpp) left in SRAM
+#
+# The results block is at offset 0x6000 of the save file (see device_bench.cpp for the layout); a run that didn't
+# finish still has every result up to the case it was on
+#
+# Usage:
+#    decode_bench_sram.py bench.sav
+#       bench.sav is the 32 KB SRAM dump, as written by emulators or a flash cart
+
+import struct
+import sys
+
+RESULTS_OFFSET = 0x6000
+MAGIC = b'PKB1'
+HEADER_FORMAT = '<4sHH'
+RESULT_FORMAT = '<20sHHII'
+
+
+def read_results(data):
+   magic, num_results, finished = struct.unpack_from(HEADER_FORMAT, data, RESULTS_OFFSET)
+   if magic != MAGIC:
+      sys.exit(f'No benchmark results in the save (found {magic!r} instead of {MAGIC!r})')
+   results = []
+   offset = RESULTS_OFFSET + struct.calcsize(HEADER_FORMAT)
+   for _ in range(num_results):
+      name, waitcnt, runs, best, worst = struct.unpack_from(RESULT_FORMAT, data, offset)
+      results.append((name.rstrip(b'\0').decode('ascii'), waitcnt, runs, best, worst))
+      offset += struct.calcsize(RESULT_FORMAT)
+   return results, finished == 1
+
+
+def main():
+   if len(sys.argv) != 2:
+      sys.exit(f'Usage: {sys.argv[0]} bench.sav')
+   with open(sys.argv[1], 'rb') as f:
+      data = f.read()
+   results, finished = read_results(data)
+
+   print(f'# {"name":<20} {"waitcnt":>7} {"runs":>5} {"best":>10} {"worst":>10} {"best frames":>12}')
+   for name, waitcnt, runs, best, worst in results:
+      print(f'{name:<22} {waitcnt:#06x} {runs:>5} {best:>10} {worst:>10} {best / 280896:>12.3f}')
+   if not finished:
+      sys.exit('The benchmarks didn\'t finish; the results stop at the case that was running')
+
+
+if __name__ == "__main__":
+   main()
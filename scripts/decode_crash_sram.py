@@ -0,0 +1,56 @@
+# Prints the last failed assert (see src/crash_screen.hpp) that was kept in SRAM
+#
+# The registers are as they were at the failed check, apart from pc, which is the return address of the call to the
+# assert handler (odd when the check was in Thumb code); look it up in the ROM's map file or with addr2line
+#
+# Usage:
+#    decode_crash_sram.py game.sav
+#       game.sav is the 32 KB SRAM dump, as written by emulators or a flash cart
+
+import struct
+import sys
+
+# Must match src/crash_screen.cpp and src/frame_monitor.hpp
+CRASH_OFFSET = 0x7E18
+MAGIC = b'PKC1'
+CRASH_FORMAT = '<4sHBB17II18I32s64s'
+SCENE_NAMES = ['title', 'menus', 'battle']
+OVERLAY_NAMES = {0: 'battle', 1: 'menus', 0xFF: 'none'}
+REGISTER_NAMES = [f'r{i}' for i in range(13)] + ['sp', 'lr', 'pc', 'cpsr']
+
+
+def read_crash(data):
+   fields = struct.unpack_from(CRASH_FORMAT, data, CRASH_OFFSET)
+   magic, line, scene, overlay = fields[:4]
+   if magic != MAGIC:
+      return None
+   registers = fields[4:21]
+   num_stack_words = fields[21]
+   stack = fields[22:22 + num_stack_words]
+   file, expression = (text.split(b'\0', 1)[0].decode('ascii', errors='replace') for text in fields[40:42])
+   return {'file': file, 'line': line, 'expression': expression,
+           'scene': SCENE_NAMES[scene] if scene < len(SCENE_NAMES) else str(scene),
+           'overlay': OVERLAY_NAMES.get(overlay, str(overlay)), 'registers': registers, 'stack': stack}
+
+
+def main():
+   if len(sys.argv) != 2:
+      sys.exit(f'Usage: {sys.argv[0]} game.sav')
+   with open(sys.argv[1], 'rb') as f:
+      data = f.read()
+   crash = read_crash(data)
+   if crash is None:
+      sys.exit('No crash in the save')
+   print(f'{crash["file"]}:{crash["line"]}: assertion failed: {crash["expression"]}')
+   print(f'scene {crash["scene"]}, overlay {crash["overlay"]}')
+   print()
+   for name, value in zip(REGISTER_NAMES, crash['registers']):
+      print(f'{name:<5}{value:08x}')
+   print()
+   sp = crash['registers'][REGISTER_NAMES.index('sp')]
+   for i, word in enumerate(crash['stack']):
+      print(f'{sp + i * 4:08x}  {word:08x}')
+
+
+if __name__ == "__main__":
+   main()
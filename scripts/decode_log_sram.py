@@ -0,0 +1,50 @@
+# Prints the debug log (src/gba_log.hpp) that was kept in SRAM, oldest entry first
+#
+# The game only logs to SRAM when it isn't running in mGBA (which gets the log through its debug registers)
+# The ring is kept across boots; sequence numbers restart with each boot, so a drop in them marks a reboot
+#
+# Usage:
+#    decode_log_sram.py game.sav
+#       game.sav is the 32 KB SRAM dump, as written by emulators or a flash cart
+
+import struct
+import sys
+
+# Must match src/gba_log.cpp
+LOG_OFFSET = 0x7A10
+MAGIC = b'PKL1'
+HEADER_FORMAT = '<4sHH'
+ENTRY_FORMAT = '<HBB60s'
+LEVEL_NAMES = ['fatal', 'error', 'warn', 'info', 'debug']
+
+
+def read_log(data):
+   magic, next_slot, num_slots = struct.unpack_from(HEADER_FORMAT, data, LOG_OFFSET)
+   if magic != MAGIC:
+      return []
+   entries = []
+   for i in range(num_slots):
+      slot = (next_slot + i) % num_slots
+      offset = LOG_OFFSET + struct.calcsize(HEADER_FORMAT) + slot * struct.calcsize(ENTRY_FORMAT)
+      sequence, level, length, text = struct.unpack_from(ENTRY_FORMAT, data, offset)
+      # Slots that have never been written are still erased
+      if level >= len(LEVEL_NAMES) or length > len(text):
+         continue
+      entries.append((sequence, LEVEL_NAMES[level], text[:length].decode('ascii', errors='replace')))
+   return entries
+
+
+def main():
+   if len(sys.argv) != 2:
+      sys.exit(f'Usage: {sys.argv[0]} game.sav')
+   with open(sys.argv[1], 'rb') as f:
+      data = f.read()
+   entries = read_log(data)
+   if not entries:
+      sys.exit('No log in the save')
+   for sequence, level, text in entries:
+      print(f'{sequence:>5} {level:<5} {text}')
+
+
+if __name__ == "__main__":
+   main()
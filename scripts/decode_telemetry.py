@@ -0,0 +1,148 @@
+# Turns the battle telemetry (src/battle_telemetry.hpp) in a save into per-battle timelines and totals
+#
+# The telemetry is only copied to SRAM in builds with PEKMUN2_TELEMETRY_SRAM defined and in perf runs; it holds the
+# last 512 events, so the oldest battle may be missing its start
+#
+# Prints a summary line per battle, then totals per map and enemy strength sorted by the slowest enemy phase, which is
+# where the game spends time without waiting for a frame
+#
+# Usage:
+#    decode_telemetry.py game.sav [--timeline]
+#       --timeline also prints every event of every battle
+
+import struct
+import sys
+from collections import defaultdict
+
+# Must match src/battle_telemetry.cpp
+TELEMETRY_OFFSET = 0x6000
+MAGIC = b'PKT1'
+HEADER_FORMAT = '<4sHHI'
+EVENT_FORMAT = '<BBHI'
+
+EVENT_NAMES = ['battle_start', 'battle_end', 'phase_start', 'phase_end', 'unit_move', 'attack', 'death', 'find_path']
+RESULTS = ['lost', 'won', 'gave up']
+PHASES = ['player', 'enemy']
+CYCLES_PER_FRAME = 280896
+MAPS_PER_CHAPTER = 9
+
+
+def read_events(data):
+   magic, num_events, _, dropped = struct.unpack_from(HEADER_FORMAT, data, TELEMETRY_OFFSET)
+   if magic != MAGIC:
+      sys.exit('No telemetry in the save (was the ROM built with PEKMUN2_TELEMETRY_SRAM?)')
+   offset = TELEMETRY_OFFSET + struct.calcsize(HEADER_FORMAT)
+   events = []
+   for _ in range(num_events):
+      type_, arg0, arg1, value = struct.unpack_from(EVENT_FORMAT, data, offset)
+      events.append((EVENT_NAMES[type_], arg0, arg1, value))
+      offset += struct.calcsize(EVENT_FORMAT)
+   return events, dropped
+
+
+def unpack_pos(packed):
+   return packed >> 8, packed & 0xFF
+
+
+def map_name(number):
+   return f'ch{number // MAPS_PER_CHAPTER + 1}-{number % MAPS_PER_CHAPTER + 1}'
+
+
+def describe(event):
+   name, arg0, arg1, value = event
+   if name == 'battle_start':
+      return f'map {map_name(arg0)}, strength {arg1 + 1}, seed {value:08x}'
+   if name == 'battle_end':
+      return f'{RESULTS[arg0]} after {arg1} turns, {value} frames'
+   if name == 'phase_start':
+      return f'turn {arg1} {PHASES[arg0]}'
+   if name == 'phase_end':
+      return f'{PHASES[arg0]}: {arg1} frames, {value} cycles ({value / CYCLES_PER_FRAME:.2f} frames)'
+   if name == 'unit_move':
+      return f'slot {arg0} {unpack_pos(value & 0xFFFF)} -> {unpack_pos(arg1)}'
+   if name == 'attack':
+      return f'slot {arg0} hits slot {arg1} for {value & 0xFFFF}, {value >> 16} HP left'
+   if name == 'death':
+      return f'slot {arg0}'
+   if name == 'find_path':
+      return f'move {arg1 >> 8} jump {arg1 & 0xFF}: {arg0} tiles, {value} cycles'
+   return ''
+
+
+# Splits the events into battles; events before the first battle_start (cut off by the ring) are dropped
+def split_battles(events):
+   battles = []
+   for event in events:
+      if event[0] == 'battle_start':
+         battles.append([event])
+      elif battles:
+         battles[-1].append(event)
+   return battles
+
+
+def summarize(battle):
+   _, map_number, strength, _ = battle[0]
+   summary = {'map': map_number, 'strength': strength, 'result': 'unfinished', 'turns': 0, 'frames': 0,
+              'enemy_cycles': [], 'player_frames': [], 'find_path_cycles': [], 'attacks': 0, 'deaths': 0}
+   for name, arg0, arg1, value in battle[1:]:
+      if name == 'battle_end':
+         summary['result'] = RESULTS[arg0]
+         summary['turns'] = arg1
+         summary['frames'] = value
+      elif name == 'phase_end':
+         if PHASES[arg0] == 'enemy':
+            summary['enemy_cycles'].append(value)
+         else:
+            summary['player_frames'].append(arg1)
+      elif name == 'find_path':
+         summary['find_path_cycles'].append(value)
+      elif name == 'attack':
+         summary['attacks'] += 1
+      elif name == 'death':
+         summary['deaths'] += 1
+   return summary
+
+
+def main():
+   args = [arg for arg in sys.argv[1:] if not arg.startswith('--')]
+   if len(args) != 1:
+      sys.exit(f'Usage: {sys.argv[0]} game.sav [--timeline]')
+   with open(args[0], 'rb') as f:
+      data = f.read()
+   events, dropped = read_events(data)
+   battles = split_battles(events)
+   if dropped:
+      print(f'# {dropped} older events were dropped')
+
+   if '--timeline' in sys.argv:
+      for battle in battles:
+         for event in battle:
+            print(f'{event[0]:<12} {describe(event)}')
+         print()
+
+   print(f'# {"map":<6} {"str":>4} {"result":<10} {"turns":>5} {"frames":>7} {"worst enemy phase":>18} '
+         f'{"find_path":>9} {"worst cycles":>12} {"attacks":>7} {"deaths":>6}')
+   by_map = defaultdict(list)
+   for battle in battles:
+      s = summarize(battle)
+      worst_enemy = max(s['enemy_cycles'], default=0)
+      worst_path = max(s['find_path_cycles'], default=0)
+      print(f'{map_name(s["map"]):<8} {s["strength"] + 1:>4} {s["result"]:<10} {s["turns"]:>5} {s["frames"]:>7} '
+            f'{worst_enemy:>18} {len(s["find_path_cycles"]):>9} {worst_path:>12} {s["attacks"]:>7} {s["deaths"]:>6}')
+      by_map[(s['map'], s['strength'])].append(s)
+
+   print()
+   print(f'# {"map":<6} {"str":>4} {"battles":>7} {"enemy phases":>12} {"mean cycles":>12} {"worst cycles":>12} '
+         f'{"worst frames":>12}')
+   totals = []
+   for (map_number, strength), summaries in by_map.items():
+      enemy_cycles = [cycles for s in summaries for cycles in s['enemy_cycles']]
+      mean = sum(enemy_cycles) // len(enemy_cycles) if enemy_cycles else 0
+      totals.append((max(enemy_cycles, default=0), map_number, strength, len(summaries), len(enemy_cycles), mean))
+   for worst, map_number, strength, num_battles, num_phases, mean in sorted(totals, reverse=True):
+      print(f'{map_name(map_number):<8} {strength + 1:>4} {num_battles:>7} {num_phases:>12} {mean:>12} {worst:>12} '
+            f'{worst / CYCLES_PER_FRAME:>12.2f}')
+
+
+if __name__ == "__main__":
+   main()
@@ -0,0 +1,141 @@
+# Reports how much IWRAM, EWRAM and ROM a ROM uses, from its GNU ld map file, and checks them against budgets
+#
+# Usage comes from the output sections' addresses and sizes; overlays share the IWRAM window, so overlapping sections
+# only count once, and the ROM copies of initialized IWRAM and EWRAM data count towards ROM
+# The stack isn't in the map: it grows down from __sp_usr towards the end of everything else in IWRAM, so what IWRAM
+# doesn't use is the stack's room (see src/stack_monitor.hpp for how much it actually takes)
+# Exits with an error if a region goes over its budget
+#
+# Budgets are a JSON object of region (iwram, ewram or rom) to bytes (see perf/memory_budgets.json)
+#
+# Usage:
+#    memory_report.py [--top count] pekmun2.map budgets.json
+#       --top sets how many of the biggest object files to list per region (10 by default)
+
+import argparse
+import json
+import os
+import re
+import sys
+from collections import defaultdict
+
+REGIONS = {
+   'iwram': (0x300_0000, 0x300_8000),
+   'ewram': (0x200_0000, 0x204_0000),
+   'rom': (0x800_0000, 0xA00_0000),
+}
+# Where devkitARM's linker script starts the user stack, if the map doesn't say
+DEFAULT_SP_USR = 0x300_7F00
+
+MAP_START = 'Linker script and memory map'
+OUTPUT_SECTION = re.compile(r'^(\.\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)(?:\s+load address 0x([0-9a-f]+))?)?\s*$')
+INPUT_SECTION = re.compile(r'^ (\.\S+|COMMON|\*fill\*)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)(?:\s+(\S.*))?)?\s*$')
+WRAPPED = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)(?:\s+load address 0x([0-9a-f]+)|\s+(\S.*))?\s*$')
+SP_USR = re.compile(r'^\s+0x([0-9a-f]+)\s+__sp_usr\s*=')
+
+
+def region_of(address):
+   for name, (start, end) in REGIONS.items():
+      if start <= address < end:
+         return name
+   return None
+
+
+# Returns the output sections as (name, address, size, load address or None), the input sections as
+# (address, size, object file) and __sp_usr
+def read_map(path):
+   with open(path) as f:
+      lines = f.read().split('\n')
+   if MAP_START not in lines:
+      sys.exit(f'{path} doesn\'t look like a GNU ld map file')
+   outputs = []
+   inputs = []
+   sp_usr = DEFAULT_SP_USR
+   i = lines.index(MAP_START) + 1
+   while i < len(lines):
+      line = lines[i]
+      i += 1
+      if match := SP_USR.match(line):
+         sp_usr = int(match[1], 16)
+      elif match := OUTPUT_SECTION.match(line):
+         name, address, size, load = match.groups()
+         # Long names put the rest on the next line
+         if address is None and i < len(lines) and (wrapped := WRAPPED.match(lines[i])):
+            address, size, load, _ = wrapped.groups()
+            i += 1
+         if address is not None:
+            outputs.append((name, int(address, 16), int(size, 16), int(load, 16) if load else None))
+      elif match := INPUT_SECTION.match(line):
+         name, address, size, obj = match.groups()
+         if address is None and i < len(lines) and (wrapped := WRAPPED.match(lines[i])):
+            address, size, _, obj = wrapped.groups()
+            i += 1
+         if address is not None:
+            inputs.append((int(address, 16), int(size, 16), os.path.basename(obj) if obj else '(padding)'))
+   return outputs, inputs, sp_usr
+
+
+# Bytes covered by a list of (start, end) ranges, counting overlaps once
+def covered(ranges):
+   total = 0
+   covered_to = 0
+   for start, end in sorted(ranges):
+      start = max(start, covered_to)
+      if end > start:
+         total += end - start
+         covered_to = end
+   return total
+
+
+def main():
+   parser = argparse.ArgumentParser(description='Checks IWRAM, EWRAM and ROM use against budgets')
+   parser.add_argument('--top', type=int, default=10)
+   parser.add_argument('map')
+   parser.add_argument('budgets')
+   args = parser.parse_args()
+
+   outputs, inputs, sp_usr = read_map(args.map)
+   with open(args.budgets) as f:
+      budgets = json.load(f)
+
+   ranges = defaultdict(list)
+   for _, address, size, load in outputs:
+      if size == 0:
+         continue
+      region = region_of(address)
+      if region is not None:
+         ranges[region].append((address, address + size))
+      if load is not None and load != address and region_of(load) == 'rom':
+         ranges['rom'].append((load, load + size))
+
+   by_object = defaultdict(lambda: defaultdict(int))
+   for address, size, obj in inputs:
+      region = region_of(address)
+      if region is not None:
+         by_object[region][obj] += size
+
+   failures = 0
+   print(f'{"region":<8} {"used":>9} {"budget":>9} {"size":>9}')
+   for region, (start, end) in REGIONS.items():
+      used = covered(ranges[region])
+      budget = budgets.get(region)
+      over = budget is not None and used > budget
+      failures += over
+      budget_text = '-' if budget is None else str(budget)
+      print(f'{region:<8} {used:>9} {budget_text:>9} {end - start:>9} {"OVER BUDGET" if over else ""}')
+
+   iwram_end = max((end for _, end in ranges['iwram']), default=REGIONS['iwram'][0])
+   print(f'\nstack room: {sp_usr - iwram_end} bytes (from 0x{iwram_end:08x} to __sp_usr at 0x{sp_usr:08x})')
+
+   for region in REGIONS:
+      print(f'\n# {region}: biggest object files')
+      biggest = sorted(by_object[region].items(), key=lambda item: item[1], reverse=True)[:args.top]
+      for obj, size in biggest:
+         print(f'{size:>9} {obj}')
+
+   if failures:
+      sys.exit(f'{failures} region(s) over budget')
+
+
+if __name__ == "__main__":
+   main()
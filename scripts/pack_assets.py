@@ -0,0 +1,195 @@
+# Packs the blobs from a set of asset manifests (see asset_blob.py) into a single
+# archive that's loaded at runtime through asset_handle (see src/assets.hpp)
+#
+# Archive layout (all values little endian, everything 4 byte aligned):
+#    char magic[4]             'P', 'A', 'K', '2'
+#    u32 num_assets
+#    entry entries[num_assets]
+#    data
+# Where each entry is:
+#    u32 offset                 from the start of the archive
+#    u32 size_and_compression   bits 0-23 are the decompressed size, 24-31 the compression type
+#
+# Compressed data uses the same format as the BIOS decompression functions (a u32 header
+# of (decompressed size << 8) | type, followed by the data)
+#
+# Usage:
+#    pack_assets.py output_header name scenes_json compressed_libs manifest...
+#       Writes the archive (output_header with the extension changed to .bin), along with the
+#       header, an assembly file and a .json listing the asset names
+#       compressed_libs is a comma separated list of the manifests (by name) that should be
+#       compressed if it makes them smaller
+#    pack_assets.py --report archive scenes_json
+#       Prints the per-scene asset size report using the archive's index
+
+import json
+import os
+import struct
+import sys
+
+MAGIC = b'PAK2'
+HEADER_SIZE = 8
+ENTRY_SIZE = 8
+
+# Must match asset_compression in src/assets.hpp
+COMPRESSION_NONE = 0
+COMPRESSION_RLE = 1
+COMPRESSION_NAMES = {COMPRESSION_NONE: 'none', COMPRESSION_RLE: 'rle'}
+
+def align4(value: int) -> int:
+   return (value + 3) & ~3
+
+# Compresses using the GBA BIOS RLE format
+def rle_compress(data: bytes) -> bytes:
+   output = bytearray(struct.pack('<I', (len(data) << 8) | 0x30))
+   raw = bytearray()
+
+   def flush_raw():
+      while raw:
+         chunk = raw[:128]
+         output.append(len(chunk) - 1)
+         output.extend(chunk)
+         del raw[:128]
+
+   i = 0
+   while i < len(data):
+      run = 1
+      while i + run < len(data) and run < 130 and data[i + run] == data[i]:
+         run += 1
+      if run >= 3:
+         flush_raw()
+         output.append(0x80 | (run - 3))
+         output.append(data[i])
+         i += run
+      else:
+         raw.append(data[i])
+         i += 1
+   flush_raw()
+   return bytes(output)
+
+def names_path(archive_path: str) -> str:
+   return f'{os.path.splitext(archive_path)[0]}.names.json'
+
+def read_index(archive_path: str) -> list[tuple[int, int, int]]:
+   with open(archive_path, 'rb') as f:
+      data = f.read()
+   assert data[:4] == MAGIC, f'{archive_path} is not an asset archive'
+   num_assets, = struct.unpack_from('<I', data, 4)
+   entries = []
+   for i in range(num_assets):
+      offset, size_and_compression = struct.unpack_from('<II', data, HEADER_SIZE + i * ENTRY_SIZE)
+      entries.append((offset, size_and_compression & 0xFF_FFFF, size_and_compression >> 24))
+   # The stored size isn't in the index; it's the distance to the next asset
+   stored_sizes = []
+   for i, (offset, _, _) in enumerate(entries):
+      end = entries[i + 1][0] if i + 1 != len(entries) else len(data)
+      stored_sizes.append(end - offset)
+   return [(size, stored, compression) for (_, size, compression), stored in zip(entries, stored_sizes)]
+
+def report(archive_path: str, scenes_path: str):
+   with open(names_path(archive_path)) as f:
+      names = json.load(f)
+   with open(scenes_path) as f:
+      scenes = json.load(f)
+   index = dict(zip(names, read_index(archive_path)))
+
+   print(f'{"asset":<32}{"size":>10}{"stored":>10}  compression')
+   for name, (size, stored, compression) in index.items():
+      print(f'{name:<32}{size:>10}{stored:>10}  {COMPRESSION_NAMES[compression]}')
+   print(f'{"total":<32}{sum(v[0] for v in index.values()):>10}{sum(v[1] for v in index.values()):>10}')
+   print()
+   print(f'{"scene":<32}{"assets":>10}{"size":>10}{"stored":>10}')
+   for scene, assets in scenes.items():
+      size = sum(index[a][0] for a in assets)
+      stored = sum(index[a][1] for a in assets)
+      print(f'{scene:<32}{len(assets):>10}{size:>10}{stored:>10}')
+
+def pack(output_header: str, name: str, scenes_path: str, compressed_libs: list[str], manifests: list[str]):
+   assets = []
+   for manifest in manifests:
+      lib_name = os.path.splitext(os.path.basename(manifest))[0]
+      with open(manifest) as f:
+         for blob in json.load(f):
+            with open(blob['path'], 'rb') as blob_file:
+               data = blob_file.read()
+            size = len(data)
+            compression = COMPRESSION_NONE
+            if lib_name in compressed_libs:
+               compressed = rle_compress(data)
+               if len(compressed) < len(data):
+                  data = compressed
+                  compression = COMPRESSION_RLE
+            assets.append((blob['symbol'], size, compression, data))
+
+   names = [a[0] for a in assets]
+   assert len(names) == len(set(names)), 'Duplicate asset names'
+
+   with open(scenes_path) as f:
+      for scene, scene_assets in json.load(f).items():
+         for asset in scene_assets:
+            if asset not in names:
+               sys.exit(f'Scene {scene} uses unknown asset {asset}')
+
+   archive = bytearray(MAGIC + struct.pack('<I', len(assets)))
+   offset = align4(HEADER_SIZE + ENTRY_SIZE * len(assets))
+   for _, size, compression, data in assets:
+      assert size < (1 << 24)
+      archive += struct.pack('<II', offset, size | (compression << 24))
+      offset = align4(offset + len(data))
+   for _, _, _, data in assets:
+      archive += data
+      archive += bytes(align4(len(archive)) - len(archive))
+
+   base_path = os.path.splitext(output_header)[0]
+   archive_path = f'{base_path}.bin'
+   with open(archive_path, 'wb') as f:
+      f.write(archive)
+
+   with open(names_path(archive_path), 'w') as f:
+      json.dump(names, f, indent=3)
+
+   with open(f'{base_path}.s', 'w') as f:
+      f.write(
+         f'   .section .rodata\n'
+         f'   .global {name}\n'
+         f'   .type {name}, STT_OBJECT\n'
+         f'   .size {name}, {len(archive)}\n'
+         f'   .balign 4\n'
+         f'{name}:\n'
+         f'   .incbin "{os.path.abspath(archive_path)}"\n'
+         # Data only, so no executable stack is needed (see asset_blob.py)
+         f'   .section .note.GNU-stack,"",%progbits\n'
+      )
+
+   with open(output_header, 'w') as f:
+      f.write(
+         f'#ifndef {name.upper()}_ARCHIVE_DATA\n'
+         f'#define {name.upper()}_ARCHIVE_DATA\n'
+         f'#include <cstdint>\n'
+         f'enum struct asset_id : std::uint16_t {{\n'
+      )
+      for asset_name in names:
+         f.write(f'   {asset_name},\n')
+      f.write(
+         f'}};\n'
+         f'inline constexpr int num_assets = {len(assets)};\n'
+         # Only intended for compile time use; the runtime uses the archive's index
+         f'inline constexpr std::uint32_t asset_sizes[]{{{", ".join(str(a[1]) for a in assets)}}};\n'
+         f'extern const std::uint32_t {name}[{len(archive) // 4}] asm("{name}");\n'
+         f'#endif\n'
+      )
+
+def main():
+   if len(sys.argv) == 4 and sys.argv[1] == '--report':
+      report(sys.argv[2], sys.argv[3])
+   elif len(sys.argv) >= 6:
+      compressed_libs = [lib for lib in sys.argv[4].split(',') if lib != '']
+      pack(sys.argv[1], sys.argv[2], sys.argv[3], compressed_libs, sys.argv[5:])
+   else:
+      sys.exit(
+         f'Usage: {sys.argv[0]} output_header name scenes_json compressed_libs manifest...\n'
+         f'       {sys.argv[0]} --report archive scenes_json'
+      )
+
+if __name__ == "__main__":
+   main()
@@ -0,0 +1,184 @@
+# Runs ROMs built with PEKMUN2_PERF_RUN (see src/perf_run.hpp) in a headless emulator and checks them against budgets
+#
+# Each scenario boots a ROM with a fresh save holding its input script, waits for the ROM to exit the emulator and
+# then reads what it left in the save: the frame monitor's and stack monitor's per-scene stats for pekmun2, or the
+# cycle counts of the fastest wait state setting for bench (see decode_bench_sram.py)
+# Exits with an error if any scenario goes over budget or doesn't finish
+#
+# Scenarios are listed in a JSON file (see perf/scenarios.json); input scripts are text files with a step per line:
+#    <frames> [keys...]
+# holding the keys (A B SELECT START RIGHT LEFT UP DOWN R L) for that many frames; # starts a comment
+#
+# Usage:
+#    perf_check.py --pekmun2 pekmun2.gba --bench bench.gba [--emulator command] [--timeout seconds] scenarios.json
+#       command runs the emulator with {rom} replaced by the ROM's path and must exit when the ROM calls
+#       perf_run::exit_swi; it defaults to mgba-rom-test
+
+import argparse
+import json
+import os
+import shlex
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import decode_bench_sram
+
+# Must match src/perf_run.hpp
+EXIT_SWI = 0xF0
+INPUT_OFFSET = 0x5C10
+INPUT_SIZE = 0x3F0
+REPORT_OFFSET = 0x7700
+INPUT_MAGIC = b'PKI1'
+REPORT_MAGIC = b'PKR2'
+SCENE_NAMES = ['title', 'menus', 'battle']
+SRAM_SIZE = 0x8000
+
+# gba::fast_waitcnt, what the game runs with
+FAST_WAITCNT = 0x46DB
+
+KEYS = ['A', 'B', 'SELECT', 'START', 'RIGHT', 'LEFT', 'UP', 'DOWN', 'R', 'L']
+DEFAULT_EMULATOR = f'mgba-rom-test -S {EXIT_SWI} {{rom}}'
+
+
+def read_input_script(path):
+   steps = []
+   with open(path) as f:
+      for line_no, line in enumerate(f, 1):
+         words = line.split('#', 1)[0].split()
+         if not words:
+            continue
+         frames = int(words[0])
+         keys = 0
+         for key in words[1:]:
+            if key.upper() not in KEYS:
+               sys.exit(f'{path}:{line_no}: unknown key {key}')
+            keys |= 1 << KEYS.index(key.upper())
+         # Steps hold a u16 frame count
+         while frames > 0:
+            steps.append((min(frames, 0xFFFF), keys))
+            frames -= 0xFFFF
+   return steps
+
+
+def make_save(steps):
+   save = bytearray(b'\xff' * SRAM_SIZE)
+   block = struct.pack('<4sHH', INPUT_MAGIC, len(steps), 0)
+   block += b''.join(struct.pack('<HH', frames, keys) for frames, keys in steps)
+   if len(block) > INPUT_SIZE:
+      sys.exit('Input script is too long to fit in SRAM')
+   save[INPUT_OFFSET:INPUT_OFFSET + len(block)] = block
+   return save
+
+
+# Returns the save the ROM left behind
+def run_rom(rom, save, emulator, timeout):
+   with tempfile.TemporaryDirectory() as temp_dir:
+      # Emulators look for the save next to the ROM
+      rom_copy = os.path.join(temp_dir, 'perf.gba')
+      save_path = os.path.join(temp_dir, 'perf.sav')
+      shutil.copyfile(rom, rom_copy)
+      with open(save_path, 'wb') as f:
+         f.write(save)
+      command = [word.replace('{rom}', rom_copy) for word in shlex.split(emulator)]
+      try:
+         subprocess.run(command, timeout=timeout, stdout=subprocess.DEVNULL, check=False)
+      except subprocess.TimeoutExpired:
+         return None
+      with open(save_path, 'rb') as f:
+         return f.read()
+
+
+def read_report(save):
+   magic, frames, num_scenes, _ = struct.unpack_from('<4sIHH', save, REPORT_OFFSET)
+   if magic != REPORT_MAGIC:
+      return None
+   scenes = {}
+   offset = REPORT_OFFSET + 12
+   for i in range(num_scenes):
+      scene_frames, late_frames, worst_lines, *histogram, stack_bytes = struct.unpack_from('<9I', save, offset)
+      scenes[SCENE_NAMES[i]] = {'frames': scene_frames, 'late_frames': late_frames, 'worst_lines': worst_lines,
+                                'histogram': histogram, 'stack_bytes': stack_bytes}
+      offset += 36
+   return frames, scenes
+
+
+# Prints each measured value against its budget and returns how many were over
+def check_budgets(scenario_name, measured, budgets):
+   failures = 0
+   for name, budget in budgets.items():
+      if name not in measured:
+         print(f'{scenario_name}/{name:<32} missing')
+         failures += 1
+         continue
+      value = measured[name]
+      over = value > budget
+      failures += over
+      print(f'{scenario_name}/{name:<32} {value:>10} {budget:>10} {"OVER BUDGET" if over else ""}')
+   return failures
+
+
+def run_game_scenario(scenario, rom, base_dir, emulator, timeout):
+   steps = read_input_script(os.path.join(base_dir, scenario['input']))
+   save = run_rom(rom, make_save(steps), emulator, timeout)
+   if save is None:
+      print(f'{scenario["name"]}: timed out')
+      return 1
+   report = read_report(save)
+   if report is None:
+      print(f'{scenario["name"]}: no report in the save (was the ROM built with PEKMUN2_PERF_RUN?)')
+      return 1
+   frames, scenes = report
+   if frames == 0:
+      print(f'{scenario["name"]}: the ROM didn\'t find the input script')
+      return 1
+   measured = {}
+   for scene, stats in scenes.items():
+      for stat in ('frames', 'late_frames', 'worst_lines', 'stack_bytes'):
+         measured[f'{scene}/{stat}'] = stats[stat]
+   print(f'{scenario["name"]}: {frames} frames')
+   return check_budgets(scenario['name'], measured, scenario['budgets'])
+
+
+def run_bench_scenario(scenario, rom, emulator, timeout):
+   save = run_rom(rom, bytes(b'\xff' * SRAM_SIZE), emulator, timeout)
+   if save is None:
+      print(f'{scenario["name"]}: timed out')
+      return 1
+   results, finished = decode_bench_sram.read_results(save)
+   if not finished:
+      print(f'{scenario["name"]}: the benchmarks didn\'t finish')
+      return 1
+   measured = {name: best for name, waitcnt, _, best, _ in results if waitcnt == FAST_WAITCNT}
+   return check_budgets(scenario['name'], measured, scenario['budgets'])
+
+
+def main():
+   parser = argparse.ArgumentParser(description='Runs the perf scenarios in a headless emulator')
+   parser.add_argument('--pekmun2', required=True)
+   parser.add_argument('--bench', required=True)
+   parser.add_argument('--emulator', default=DEFAULT_EMULATOR)
+   parser.add_argument('--timeout', type=float, default=300)
+   parser.add_argument('scenarios')
+   args = parser.parse_args()
+
+   with open(args.scenarios) as f:
+      scenarios = json.load(f)
+   base_dir = os.path.dirname(os.path.abspath(args.scenarios))
+   failures = 0
+   for scenario in scenarios:
+      if scenario['rom'] == 'pekmun2':
+         failures += run_game_scenario(scenario, args.pekmun2, base_dir, args.emulator, args.timeout)
+      elif scenario['rom'] == 'bench':
+         failures += run_bench_scenario(scenario, args.bench, args.emulator, args.timeout)
+      else:
+         sys.exit(f'Unknown ROM {scenario["rom"]} in scenario {scenario["name"]}')
+   if failures:
+      sys.exit(f'{failures} budget(s) exceeded or scenario(s) failed')
+
+
+if __name__ == "__main__":
+   main()
@@ -1,12 +1,11 @@
 import cv2
 import sys
 
+from asset_blob import Blob, write_asset
+
 if len(sys.argv) != 4:
    sys.exit(f'Usage: {sys.argv[0]} input_file output_file variable_name')
 
-def to_cpp_array(a_list: list[int]) -> str:
-   return str(a_list).replace("[", "{").replace("]", "};")
-
 def make_gba_color(r, g, b):
    def conv(val):
       low_val = 0
@@ -19,13 +18,5 @@ for row in cv2.imread(sys.argv[1]):
    for r, g, b in row:
       values.append(make_gba_color(r, g, b))
 
-with open(sys.argv[2], 'w') as f:
-   header_guard = sys.argv[3].upper()
-   name = sys.argv[3]
-   f.write(
-      f'#ifndef {header_guard}_IMAGE_DATA\n'
-      f'#define {header_guard}_IMAGE_DATA\n'
-      f'#include <cstdint>\n'
-      f'inline constexpr std::uint16_t {name}[]{to_cpp_array(values)}\n'
-      f'#endif\n'
-   )
+name = sys.argv[3]
+write_asset(sys.argv[2], f'{name.upper()}_IMAGE_DATA', [Blob(name, 'std::uint16_t', values)])
@@ -3,12 +3,11 @@
 import json
 import sys
 
+from asset_blob import Blob, write_asset
+
 if len(sys.argv) != 4:
    sys.exit(f'Usage: {sys.argv[0]} input_file output_file variable_name')
 
-def to_cpp_array(a_list: list[int]) -> str:
-   return str(a_list).replace("[", "{").replace("]", "};")
-
 with open(sys.argv[1]) as f:
    data = json.load(f)
 
@@ -21,13 +20,5 @@ assert height == 20
 
 adj_tiles = [x - 1 for x in tiles]
 
-with open(sys.argv[2], 'w') as f:
-   header_guard = sys.argv[3].upper()
-   name = sys.argv[3]
-   f.write(
-      f'#ifndef {header_guard}_TILEMAP_DATA\n'
-      f'#define {header_guard}_TILEMAP_DATA\n'
-      f'#include <cstdint>\n'
-      f'inline constexpr std::uint16_t {name}[]{to_cpp_array(adj_tiles)}\n'
-      f'#endif\n'
-   )
+name = sys.argv[3]
+write_asset(sys.argv[2], f'{name.upper()}_TILEMAP_DATA', [Blob(name, 'std::uint16_t', adj_tiles)])
@@ -4,12 +4,11 @@
 import cv2
 import sys
 
+from asset_blob import Blob, write_asset
+
 if len(sys.argv) != 4:
    sys.exit(f'Usage: {sys.argv[0]} input_file output_file variable_name')
 
-def to_cpp_array(a_list: list[int]) -> str:
-   return str(a_list).replace("[", "{").replace("]", "};")
-
 def make_gba_color(r, g, b):
    # Converts from from 0-255 range to GBA range
    def conv(val):
@@ -60,15 +59,10 @@ def process_image(image) -> (list[int], list[int]):
    return bit32_vals, image_pal
 
 
-with open(sys.argv[2], 'w') as f:
-   vals, pal = process_image(cv2.imread(sys.argv[1]))
-   header_guard = sys.argv[3].upper()
-   name = sys.argv[3]
-   f.write(
-      f'#ifndef {header_guard}_IMAGE_DATA\n'
-      f'#define {header_guard}_IMAGE_DATA\n'
-      f'#include <cstdint>\n'
-      f'inline constexpr std::uint32_t {name}[]{to_cpp_array(vals)}\n'
-      f'inline constexpr std::uint16_t {name}_pal[]{to_cpp_array(pal)}\n'
-      f'#endif\n'
-   )
+vals, pal = process_image(cv2.imread(sys.argv[1]))
+name = sys.argv[3]
+write_asset(
+   sys.argv[2],
+   f'{name.upper()}_IMAGE_DATA',
+   [Blob(name, 'std::uint32_t', vals), Blob(f'{name}_pal', 'std::uint16_t', pal)]
+)
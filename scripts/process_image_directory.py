@@ -3,12 +3,11 @@ import sys
 import glob
 import os
 
+from asset_blob import Blob, write_asset
+
 if len(sys.argv) != 3:
    sys.exit(f'{sys.argv[0]} input_directory output_file')
 
-def to_cpp_array(a_list: list[int]) -> str:
-   return str(a_list).replace("[", "{").replace("]", "};")
-
 def make_gba_color(r, g, b):
    def conv(val):
       low_val = 0
@@ -30,7 +29,7 @@ for row in pal_raw:
 
 images = {}
 
-for image in glob.glob(f'{input_dir}/*.png'):
+for image in sorted(glob.glob(f'{input_dir}/*.png')):
    if image == pal_path:
       continue
    file_name = os.path.basename(image)
@@ -61,21 +60,9 @@ for image in glob.glob(f'{input_dir}/*.png'):
    for a, b, c, d in zip(*([iter(raw_vals)] * 4)):
       images[file_name].append(int(d << 24 | c << 16 | b << 8 | a))
 
-with open(sys.argv[2], 'w') as f:
-   base_name = os.path.basename(input_dir)
-   header_guard = base_name.upper()
-   gba_pal = [make_gba_color(r, g, b) for r, g, b in pal]
-   f.write(
-      f'#ifndef {header_guard}_PALETTE_DATA\n'
-      f'#define {header_guard}_PALETTE_DATA\n'
-      f'#include <cstdint>\n'
-      f'namespace {base_name} {{\n'
-      f'inline constexpr std::uint16_t palette[]{to_cpp_array(gba_pal)}\n'
-   )
-   for raw_name, data in images.items():
-      name = os.path.splitext(raw_name)[0]
-      f.write(f'inline constexpr std::uint32_t {name}[]{to_cpp_array(data)}\n')
-   f.write(
-      f'}}\n'
-      f'#endif\n'
-   )
+base_name = os.path.basename(input_dir)
+gba_pal = [make_gba_color(r, g, b) for r, g, b in pal]
+blobs = [Blob('palette', 'std::uint16_t', gba_pal)]
+for raw_name, data in images.items():
+   blobs.append(Blob(os.path.splitext(raw_name)[0], 'std::uint32_t', data))
+write_asset(sys.argv[2], f'{base_name.upper()}_PALETTE_DATA', blobs, namespace=base_name)
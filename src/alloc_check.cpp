@@ -0,0 +1,143 @@
+#include "alloc_check.hpp"
+
+#ifdef PEKMUN2_ALLOC_CHECK
+
+#include "gba.hpp"
+#include "gba_log.hpp"
+#include "static_vector.hpp"
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <malloc.h>
+#include <new>
+
+// The linker sends calls to these to the __wrap_ versions (see CMakeLists.txt)
+extern "C" {
+void* __real_malloc(std::size_t size);
+void* __real_calloc(std::size_t count, std::size_t size);
+void* __real_realloc(void* ptr, std::size_t size);
+void* __wrap_malloc(std::size_t size);
+void* __wrap_calloc(std::size_t count, std::size_t size);
+void* __wrap_realloc(void* ptr, std::size_t size);
+}
+
+namespace {
+
+struct call_site {
+   std::uintptr_t address;
+   std::uint32_t allocations;
+   std::uint32_t bytes;
+};
+
+constexpr int max_call_sites = 16;
+
+bool started = false;
+std::uint32_t startup_allocations = 0;
+static_vector<call_site, max_call_sites> call_sites;
+// Allocations from call sites that didn't fit in call_sites
+std::uint32_t other_allocations = 0;
+
+// The caller's address is odd for Thumb code, as it is in a return address
+void note_allocation(std::size_t size, const void* caller) noexcept
+{
+   if (!started) {
+      ++startup_allocations;
+      return;
+   }
+   const auto address = reinterpret_cast<std::uintptr_t>(caller);
+#ifdef PEKMUN2_ALLOC_FORBID
+   // Kept for the crash screen, which only takes a pointer
+   static char message[gba::log::max_message_size];
+   const auto end = fmt::format_to_n(message, std::size(message) - 1, "no allocating: {} bytes from {:08x}", size,
+      address);
+   *end.out = '\0';
+   gba::detail::assert_failed(GBA_DETAIL_FILE_NAME, __LINE__, message);
+#else
+   const auto site = std::find_if(
+      call_sites.begin(), call_sites.end(), [&](const call_site& known) { return known.address == address; });
+   if (site != call_sites.end()) {
+      site->allocations += 1;
+      site->bytes += size;
+      return;
+   }
+   if (call_sites.size() == max_call_sites) {
+      ++other_allocations;
+      return;
+   }
+   call_sites.push_back(call_site{address, 1, static_cast<std::uint32_t>(size)});
+   GBA_LOG(warn, "allocation of {} bytes from {:08x}", size, address);
+#endif
+}
+
+} // anonymous namespace
+
+namespace alloc_check {
+
+void startup_finished() noexcept
+{
+   started = true;
+   GBA_LOG(info, "{} allocations during startup", startup_allocations);
+}
+
+void log_report() noexcept
+{
+   for (const auto& site : call_sites) {
+      GBA_LOG(warn, "{:08x}: {} allocations, {} bytes", site.address, site.allocations, site.bytes);
+   }
+   if (other_allocations != 0) {
+      GBA_LOG(warn, "{} allocations from other call sites", other_allocations);
+   }
+   // uordblks is the space in use, arena what newlib has taken from EWRAM for the heap
+   const auto heap = mallinfo();
+   GBA_LOG(warn, "heap: {} of {} bytes in use", heap.uordblks, heap.arena);
+   gba::log::flush();
+}
+
+} // namespace alloc_check
+
+void* __wrap_malloc(std::size_t size)
+{
+   note_allocation(size, __builtin_return_address(0));
+   return __real_malloc(size);
+}
+
+void* __wrap_calloc(std::size_t count, std::size_t size)
+{
+   note_allocation(count * size, __builtin_return_address(0));
+   return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, std::size_t size)
+{
+   note_allocation(size, __builtin_return_address(0));
+   return __real_realloc(ptr, size);
+}
+
+// Replaced so the call site is whoever used new rather than libstdc++
+// Exceptions are disabled, so running out of memory can only fail an assert
+void* operator new(std::size_t size)
+{
+   note_allocation(size, __builtin_return_address(0));
+   const auto ptr = __real_malloc(std::max<std::size_t>(size, 1));
+   GBA_ASSERT(ptr != nullptr);
+   return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+   note_allocation(size, __builtin_return_address(0));
+   const auto ptr = __real_malloc(std::max<std::size_t>(size, 1));
+   GBA_ASSERT(ptr != nullptr);
+   return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef ALLOC_CHECK_HPP
+#define ALLOC_CHECK_HPP
+
+// Heap allocation checks, for keeping the game allocation-free once it's running
+// Configuring with PEKMUN2_ALLOC_CHECK=count or forbid wraps malloc, calloc and realloc at link time and replaces
+// operator new; allocations made after startup_finished are then either logged (a warning per call site the first
+// time it allocates, with its address for addr2line) or fail an assert naming the call site, even in release builds
+// Only newlib's public entry points are wrapped, so its own internal allocations (stdio buffers) aren't seen
+// Without PEKMUN2_ALLOC_CHECK (and in the host build) nothing here does anything
+namespace alloc_check {
+
+#ifdef PEKMUN2_ALLOC_CHECK
+
+// Allocations made before this are expected and only counted
+void startup_finished() noexcept;
+
+// Logs how many allocations and bytes each call site has made since startup and how much of the heap is in use
+void log_report() noexcept;
+
+#else
+
+inline void startup_finished() noexcept {}
+inline void log_report() noexcept {}
+
+#endif
+
+} // namespace alloc_check
+
+#endif // ALLOC_CHECK_HPP
@@ -0,0 +1,106 @@
+#include "assets.hpp"
+
+#include <array>
+
+namespace {
+
+// See scripts/pack_assets.py for the full layout
+struct archive_header {
+   std::array<char, 4> magic;
+   std::uint32_t num_assets;
+};
+
+constexpr std::array<char, 4> archive_magic{{'P', 'A', 'K', '2'}};
+
+const archive_header& header() noexcept { return *reinterpret_cast<const archive_header*>(asset_archive); }
+
+const asset_entry* index_entries() noexcept
+{
+   return reinterpret_cast<const asset_entry*>(asset_archive + sizeof(archive_header) / 4);
+}
+
+// Decompresses data in the BIOS RLE format
+// Writes are done 16 bits at a time so this can write directly to VRAM
+// Runs from IWRAM since it's a byte at a time loop over a whole asset
+GBA_IWRAM_CODE void rle_decompress(const std::uint8_t* src, volatile std::uint16_t* dest) noexcept
+{
+   const std::uint32_t bios_header = src[0] | (src[1] << 8) | (src[2] << 16) | (src[3] << 24);
+   int remaining = bios_header >> 8;
+   src += 4;
+
+   std::uint16_t low_byte = 0;
+   bool have_low_byte = false;
+   const auto write_byte = [&](std::uint8_t value) {
+      if (have_low_byte) {
+         *dest = low_byte | (value << 8);
+         ++dest;
+      }
+      else {
+         low_byte = value;
+      }
+      have_low_byte = !have_low_byte;
+   };
+
+   while (remaining > 0) {
+      const auto flag = *src;
+      ++src;
+      if (flag & 0b1000'0000) {
+         const auto length = (flag & 0b0111'1111) + 3;
+         const auto value = *src;
+         ++src;
+         for (int i = 0; i < length; ++i) {
+            write_byte(value);
+         }
+         remaining -= length;
+      }
+      else {
+         const auto length = (flag & 0b0111'1111) + 1;
+         for (int i = 0; i < length; ++i) {
+            write_byte(*src);
+            ++src;
+         }
+         remaining -= length;
+      }
+   }
+   // Odd sizes don't happen in practice, but don't drop the last byte if they do
+   if (have_low_byte) {
+      *dest = low_byte;
+   }
+}
+
+} // anonymous namespace
+
+asset_handle::asset_handle(asset_id id) noexcept : entry{index_entries() + static_cast<int>(id)}
+{
+   GBA_ASSERT(header().magic == archive_magic);
+   GBA_ASSERT(static_cast<std::uint32_t>(id) < header().num_assets);
+}
+
+const std::uint8_t* asset_handle::raw_data() const noexcept
+{
+   return reinterpret_cast<const std::uint8_t*>(asset_archive) + entry->offset;
+}
+
+volatile std::uint16_t* asset_handle::load(volatile std::uint16_t* dest) const noexcept
+{
+   switch (compression()) {
+   case asset_compression::none: {
+      const auto to_copy = data<std::uint16_t>();
+      return gba::dma3_copy(to_copy.data(), to_copy.data() + to_copy.size(), dest);
+   }
+   case asset_compression::rle: rle_decompress(raw_data(), dest); break;
+   }
+   return dest + size() / 2;
+}
+
+volatile std::uint32_t* asset_handle::load(volatile std::uint32_t* dest) const noexcept
+{
+   switch (compression()) {
+   case asset_compression::none: {
+      const auto to_copy = data<std::uint32_t>();
+      return gba::dma3_copy(to_copy.data(), to_copy.data() + to_copy.size(), dest);
+   }
+   case asset_compression::rle: rle_decompress(raw_data(), reinterpret_cast<volatile std::uint16_t*>(dest)); break;
+   }
+   return dest + size() / 4;
+}
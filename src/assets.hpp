@@ -0,0 +1,74 @@
+#ifndef ASSETS_HPP
+#define ASSETS_HPP
+
+#include "generated/asset_archive.hpp"
+
+#include "gba.hpp"
+
+#include <cstdint>
+#include <span>
+
+// Must match the values in scripts/pack_assets.py
+enum struct asset_compression : std::uint8_t {
+   none,
+   rle
+};
+
+// An entry in the archive's index
+struct asset_entry {
+   std::uint32_t offset;
+   // Bits 0-23 are the decompressed size, 24-31 are the compression type
+   std::uint32_t size_and_compression;
+};
+
+// Only for use at compile time (e.g. for working out tile offsets); use asset_handle at runtime
+constexpr std::uint32_t asset_size(asset_id id) noexcept { return asset_sizes[static_cast<int>(id)]; }
+
+// A reference to an asset in the archive
+// Nothing is read from the asset until it's used, so each scene only pays for what it loads
+struct asset_handle {
+public:
+   explicit asset_handle(asset_id id) noexcept;
+
+   // The size of the asset once decompressed (in bytes)
+   std::uint32_t size() const noexcept { return entry->size_and_compression & 0x00FF'FFFF; }
+
+   asset_compression compression() const noexcept
+   {
+      return static_cast<asset_compression>(entry->size_and_compression >> 24);
+   }
+
+   // Only uncompressed assets can be accessed in place
+   template<typename T>
+   std::span<const T> data() const noexcept
+   {
+      GBA_ASSERT(compression() == asset_compression::none);
+      return {reinterpret_cast<const T*>(raw_data()), size() / sizeof(T)};
+   }
+
+   // The asset as it's stored in the archive, 4-byte aligned; compressed assets start with the BIOS header, so can be
+   // passed to gba::bios's decompression calls
+   const std::uint32_t* stored_data() const noexcept { return reinterpret_cast<const std::uint32_t*>(raw_data()); }
+
+   // Copies (or decompresses) the asset to dest
+   // Like dma3_copy this returns the location after the end of the written data
+   volatile std::uint16_t* load(volatile std::uint16_t* dest) const noexcept;
+   volatile std::uint32_t* load(volatile std::uint32_t* dest) const noexcept;
+
+private:
+   const std::uint8_t* raw_data() const noexcept;
+
+   const asset_entry* entry;
+};
+
+inline volatile std::uint16_t* load_asset(asset_id id, volatile std::uint16_t* dest) noexcept
+{
+   return asset_handle{id}.load(dest);
+}
+
+inline volatile std::uint32_t* load_asset(asset_id id, volatile std::uint32_t* dest) noexcept
+{
+   return asset_handle{id}.load(dest);
+}
+
+#endif // ASSETS_HPP
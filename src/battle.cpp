@@ -1,12 +1,25 @@
 #include "battle.hpp"
 
+#include "assets.hpp"
+#include "battle_journal.hpp"
+#include "battle_telemetry.hpp"
+#include "battle_tilemap.hpp"
+#include "battle_units.hpp"
 #include "classes.hpp"
 #include "common_funcs.hpp"
 #include "constants.hpp"
+#include "debug_layer.hpp"
+#include "frame_monitor.hpp"
 #include "gba.hpp"
+#include "gba_log.hpp"
+#include "overlay.hpp"
 #include "pathfinding.hpp"
+#include "prng.hpp"
+#include "profiler.hpp"
+#include "scene_arena.hpp"
 #include "static_vector.hpp"
 
+#include <optional>
 #include <tuple>
 
 namespace {
@@ -14,153 +27,81 @@ namespace {
 constexpr auto screen_width = 240;
 constexpr auto screen_height = 160;
 
-constexpr auto bg0_screen_block = gba::bg_opt::screen_base_block::b62;
-constexpr auto bg1_screen_block = gba::bg_opt::screen_base_block::b60;
-constexpr auto bg2_screen_block = gba::bg_opt::screen_base_block::b58;
-constexpr auto bg3_screen_block = gba::bg_opt::screen_base_block::b56;
-
-constexpr auto blank_tile = tile_locs::start_tileset + 17;
-
-const auto tile_at = [](const std::uint16_t* layer_data, unsigned x, unsigned y) {
-   if (x >= tilemap_width || y >= tilemap_height) {
-      return gba::make_tile(blank_tile, 1);
+// Sprite updates run every time the camera moves so they're in the battle overlay (like the layer updates)
+// Positions obj_num over the map square (x, y) or hides it if it's off screen
+GBA_IWRAM_OVERLAY_CODE(BATTLE_OVERLAY) void place_sprite(
+   const map_data& map, int camera_x, int camera_y, int x, int y, int obj_num, int x_adj, int y_adj) noexcept
+{
+   const auto disp_x = x_adj - camera_x + x * 16 + y * 16;
+   const auto disp_y = y_adj + -camera_y + y * 8 - x * 8 - map.height_at(x, y) * 8 + map.y_offset * 8;
+   if (disp_x < -16 || disp_x >= screen_width || disp_y < -32 || disp_y >= screen_height) {
+      gba::obj{obj_num}.set_attr0(gba::obj_attr0_options{}.set(gba::obj_opt::display::disable));
    }
    else {
-      return layer_data[x + y * 60];
-   }
-};
-
-const auto redraw_layer
-   = [](int camera_x, int camera_y, const std::uint16_t* layer_data, gba::bg_opt::screen_base_block loc) {
-        // If the camera is negative we need to subtract 7 to make sure we're updating
-        // the tile that's showing at the edge
-        const auto offset_x = camera_x < 0 ? (camera_x - 7) / 8 : camera_x / 8;
-        const auto offset_y = camera_y < 0 ? (camera_y - 7) / 8 : camera_y / 8;
-        for (int y = 0; y != 21; ++y) {
-           const unsigned tile_y = y + offset_y;
-           for (int x = 0; x != 31; ++x) {
-              const unsigned tile_x = x + offset_x;
-              *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
-           }
-        }
-     };
-
-const auto scroll_layer = [](int camera_x,
-                             int camera_y,
-                             const std::uint16_t* layer_data,
-                             gba::bg_opt::screen_base_block loc,
-                             int delta_x,
-                             int delta_y) {
-   const auto offset_x = camera_x < 0 ? (camera_x - 7) / 8 : camera_x / 8;
-   const auto offset_y = camera_y < 0 ? (camera_y - 7) / 8 : camera_y / 8;
-   // TODO: Is there a more compact way to represent this?
-   if (delta_x < 0) {
-      const auto x_scroll_amount = std::min(std::abs(delta_x - 7) / 8, 31);
-      for (int x = 0; x != x_scroll_amount; ++x) {
-         const unsigned tile_x = x + offset_x;
-         for (int y = 0; y != 21; ++y) {
-            const unsigned tile_y = y + offset_y;
-            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
-         }
-      }
-   }
-   else if (delta_x > 0) {
-      const auto x_scroll_amount = std::min((delta_x + 7) / 8, 31);
-      for (int x = 31 - x_scroll_amount; x != 31; ++x) {
-         const unsigned tile_x = x + offset_x;
-         for (int y = 0; y != 21; ++y) {
-            const unsigned tile_y = y + offset_y;
-            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
-         }
-      }
-   }
-   if (delta_y < 0) {
-      const auto y_scroll_amount = std::min(std::abs(delta_y - 7) / 8, 21);
-      for (int y = 0; y != y_scroll_amount; ++y) {
-         const unsigned tile_y = y + offset_y;
-         for (int x = 0; x != 31; ++x) {
-            const unsigned tile_x = x + offset_x;
-            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
-         }
-      }
-   }
-   else if (delta_y > 0) {
-      const auto y_scroll_amount = std::min((delta_y + 7) / 8, 21);
-      for (int y = 21 - y_scroll_amount; y != 21; ++y) {
-         const unsigned tile_y = y + offset_y;
-         for (int x = 0; x != 31; ++x) {
-            const unsigned tile_x = x + offset_x;
-            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
-         }
-      }
+      using namespace gba::obj_opt;
+      gba::obj{obj_num}.set_attr0(gba::obj_attr0_options{}.set(display::enable));
+      gba::obj{obj_num}.set_loc(disp_x, disp_y);
+      gba::obj{obj_num}.set_attr2(gba::obj_attr2_options{}.set(
+         map.sprite_is_high_priority_at(x, y) ? gba::obj_opt::priority{2} : gba::obj_opt::priority{3}));
    }
-};
-
-const auto fill_move_buffers = [](const full_map_info& map_info,
-                                  int palette_num,
-                                  const static_vector<pos, num_squares>& tiles,
-                                  std::array<std::uint16_t, tilemap_width * tilemap_height>& low_priority_buffer,
-                                  std::array<std::uint16_t, tilemap_width * tilemap_height>& high_priority_buffer) {
-   for (const auto& tile : tiles) {
-      auto& buffer
-         = map_info.map->tile_is_high_priority_at(tile.x, tile.y) ? high_priority_buffer : low_priority_buffer;
-      const auto tile_x = tile.x * 2 + tile.y * 2;
-      const auto tile_y = map_info.map->y_offset + tile.y - tile.x - map_info.map->height_at(tile.x, tile.y);
-      // This is really messy/bad but it works so oh well
-      constexpr auto start_move_indic = tile_locs::start_move_indic;
-      if (buffer[tile_x + tile_y * tilemap_width] == blank_tile) {
-         buffer[tile_x + 0 + tile_y * tilemap_width] = gba::make_tile(start_move_indic, palette_num);
-         buffer[tile_x + 1 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 1, palette_num);
-      }
-      else {
-         buffer[tile_x + 0 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 8, palette_num);
-         buffer[tile_x + 1 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 9, palette_num);
-      }
-      if (buffer[tile_x + 2 + tile_y * tilemap_width] == blank_tile) {
-         buffer[tile_x + 2 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 2, palette_num);
-         buffer[tile_x + 3 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 3, palette_num);
-      }
-      else {
-         buffer[tile_x + 2 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 10, palette_num);
-         buffer[tile_x + 3 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 11, palette_num);
-      }
-      if (buffer[tile_x + (tile_y + 1) * tilemap_width] == blank_tile) {
-         buffer[tile_x + 0 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 4, palette_num);
-         buffer[tile_x + 1 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 5, palette_num);
-      }
-      else {
-         buffer[tile_x + 0 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 10, palette_num);
-         buffer[tile_x + 1 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 11, palette_num);
-      }
-      if (buffer[tile_x + 2 + (tile_y + 1) * tilemap_width] == blank_tile) {
-         buffer[tile_x + 2 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 6, palette_num);
-         buffer[tile_x + 3 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 7, palette_num);
-      }
-      else {
-         buffer[tile_x + 2 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 8, palette_num);
-         buffer[tile_x + 3 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 9, palette_num);
-      }
+}
+
+// find_path, recording how long it took in the telemetry
+static_vector<pos, num_squares> timed_find_path(
+   pos from, int move, int jump, const full_map_info& map_info, std::span<const pos> blocked) noexcept
+{
+   const auto start = gba::cycle_count();
+   auto tiles = find_path(from.x, from.y, move, jump, map_info, blocked);
+   battle_telemetry::record(
+      battle_telemetry::event_type::find_path, tiles.size(), move << 8 | jump, gba::cycle_count() - start);
+   return tiles;
+}
+
+void record_move(unit_handle unit, pos from, pos to) noexcept
+{
+   battle_telemetry::record(
+      battle_telemetry::event_type::unit_move, unit.slot, battle_telemetry::pack(to), battle_telemetry::pack(from));
+}
+
+void record_attack(const battle_units& units, unit_handle attacker, unit_handle defender, int damage) noexcept
+{
+   using battle_telemetry::event_type;
+   const auto hp_left = static_cast<std::uint16_t>(std::max(units.hp(defender), 0));
+   battle_telemetry::record(
+      event_type::attack, attacker.slot, defender.slot, static_cast<std::uint16_t>(damage) | hp_left << 16);
+   if (hp_left == 0) {
+      battle_telemetry::record(event_type::death, defender.slot, 0, 0);
    }
-};
+}
 
 } // anonymous namespace
 
 // Returns true if the map is beaten, false otherwise
-bool do_battle(file_save_data& save_data, const full_map_info& map_info, int enemy_strength) noexcept
+bool do_battle(
+   file_save_data& save_data, const full_map_info& map_info, int enemy_strength, std::uint32_t seed) noexcept
 {
    disable_all_sprites();
+   // Everything allocated from the scene arenas below is freed when the battle returns
+   const scene_scope scope;
+   // Swapped back to the menu code when the battle returns
+   const overlay_scope battle_code{overlay_id::battle};
+   const frame_monitor::scene_scope battle_scene{frame_scene::battle};
+   battle_rng rng{seed};
+   GBA_LOG(info, "battle: strength {} seed {:08x}", enemy_strength, seed);
+   battle_telemetry::battle_started(map_info.map_number, enemy_strength, seed, save_data.frame_count);
 
    // load all the enemies
    constexpr auto start_tile_offset = 24;
-   static_vector<combatant, max_enemies> enemies;
-   static_vector<character, max_enemies> enemy_stats;
-   static_vector<combatant, max_player_units_on_map> player_units;
+   // Read every frame, so in IWRAM; the full characters are only read for stat calculations
+   auto& units = scene_new<battle_units>(memory_hint::iwram);
+   auto& enemy_stats = scene_new<static_vector<character, max_enemies>>(memory_hint::ewram);
+   const auto unit_tile_no = [](unit_handle unit) { return start_tile_offset + unit.slot * 8; };
+   // Undone if the battle is lost
+   auto& journal = scene_new<battle_journal>(memory_hint::ewram, save_data.characters);
    for (int i = 0; i < std::ssize(map_info.base_enemies); ++i) {
       const auto& enemy = map_info.base_enemies[i];
       if (enemy.level > 0) {
-         enemies.push_back({});
          enemy_stats.push_back({});
-         auto& new_enemy = enemies.back();
          auto& new_stats = enemy_stats.back();
          if (enemy_strength > 0) {
             const auto level = enemy.level;
@@ -170,26 +111,22 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
          else {
             new_stats.level = enemy.level;
          }
-         new_enemy.x = enemy.x;
-         new_enemy.y = enemy.y;
-         new_enemy.stats = &new_stats;
-         new_enemy.is_enemy = true;
-         new_enemy.is_boss = enemy.is_boss;
          new_stats.class_ = enemy.class_;
          new_stats.bases = class_data[enemy.class_].stats;
-         new_stats.calc_stats(true);
+         new_stats.calc_stats(&rng.stats);
          new_stats.fully_heal();
-         const auto tile_offset = start_tile_offset + i * 8;
-         new_enemy.tile_no = tile_offset;
-         const auto& tile_data = class_data[enemy.class_].sprite;
-         gba::dma3_copy(std::begin(tile_data), std::end(tile_data), gba::base_obj_tile_addr(0) + tile_offset * 8);
+         const auto new_enemy = units.add_enemy(i, new_stats, {enemy.x, enemy.y}, enemy.is_boss);
+         load_asset(class_data[enemy.class_].sprite, gba::base_obj_tile_addr(0) + unit_tile_no(new_enemy) * 8);
       }
    }
 
    // E sprite for indicating a unit has acted
    const auto end_sprite_loc_tile = (max_enemies + max_player_units_on_map) * 8;
    const auto end_sprite_offset = end_sprite_loc_tile * 8;
-   gba::dma3_copy(std::begin(obj_pal1::end), std::end(obj_pal1::end), gba::base_obj_tile_addr(0) + end_sprite_offset);
+   load_asset(asset_id::obj_pal1_end, gba::base_obj_tile_addr(0) + end_sprite_offset);
+
+   // Health bar tiles are copied piecemeal as HP changes so they're used in place
+   const auto health_bar = asset_handle{asset_id::obj_pal1_health_bar}.data<std::uint32_t>();
 
    const auto bg0_tiles = gba::bg_screen_loc(bg0_screen_block);
    const auto bg1_tiles = gba::bg_screen_loc(bg1_screen_block);
@@ -206,34 +143,18 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
 
    set_camera(map_info.base_x, map_info.base_y);
 
-   combatant cursor;
-   character cursor_char;
-   cursor.x = map_info.base_x;
-   cursor.y = map_info.base_y;
-   cursor.tile_no = 0;
-   cursor.stats = &cursor_char;
-   cursor_char.class_ = cursor_class;
+   // The cursor's sprite is at tile 0
+   pos cursor{map_info.base_x, map_info.base_y};
 
-   std::array<std::uint16_t, tilemap_width * tilemap_height> low_priority_buffer;
-   std::array<std::uint16_t, tilemap_width * tilemap_height> high_priority_buffer;
+   // 4.8 KB each and only read when the screen scrolls
+   auto& low_priority_buffer = scene_new<tilemap_buffer>(memory_hint::ewram);
+   auto& high_priority_buffer = scene_new<tilemap_buffer>(memory_hint::ewram);
 
    gba::dma3_fill(low_priority_buffer.begin(), low_priority_buffer.end(), blank_tile);
    gba::dma3_fill(high_priority_buffer.begin(), high_priority_buffer.end(), blank_tile);
 
    const auto display_sprite = [&](int x, int y, int obj_num, int x_adj, int y_adj) {
-      const auto disp_x = x_adj - camera_x + x * 16 + y * 16;
-      const auto disp_y
-         = y_adj + -camera_y + y * 8 - x * 8 - map_info.map->height_at(x, y) * 8 + map_info.map->y_offset * 8;
-      if (disp_x < -16 || disp_x >= screen_width || disp_y < -32 || disp_y >= screen_height) {
-         gba::obj{obj_num}.set_attr0(gba::obj_attr0_options{}.set(gba::obj_opt::display::disable));
-      }
-      else {
-         using namespace gba::obj_opt;
-         gba::obj{obj_num}.set_attr0(gba::obj_attr0_options{}.set(display::enable));
-         gba::obj{obj_num}.set_loc(disp_x, disp_y);
-         gba::obj{obj_num}.set_attr2(gba::obj_attr2_options{}.set(
-            map_info.map->sprite_is_high_priority_at(x, y) ? gba::obj_opt::priority{2} : gba::obj_opt::priority{3}));
-      }
+      place_sprite(*map_info.map, camera_x, camera_y, x, y, obj_num, x_adj, y_adj);
    };
 
    const auto init_screen = [&]() {
@@ -283,8 +204,8 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
 
       redraw_layer(camera_x, camera_y, high_priority_buffer.data(), bg0_screen_block);
       redraw_layer(camera_x, camera_y, low_priority_buffer.data(), bg1_screen_block);
-      redraw_layer(camera_x, camera_y, map_info.map->high_priority_tiles.data(), bg2_screen_block);
-      redraw_layer(camera_x, camera_y, map_info.map->low_priority_tiles.data(), bg3_screen_block);
+      redraw_layer(camera_x, camera_y, map_info.map->high_priority_tiles, bg2_screen_block);
+      redraw_layer(camera_x, camera_y, map_info.map->low_priority_tiles, bg3_screen_block);
 
       gba::bg0.set_scroll(camera_x, camera_y);
       gba::bg1.set_scroll(camera_x, camera_y);
@@ -308,11 +229,10 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
       }
 
       // Set-up cursor sprite
-      const auto start_base
-         = gba::dma3_copy(std::begin(obj_pal1::cursor), std::end(obj_pal1::cursor), gba::base_obj_tile_addr(0));
+      const auto start_base = load_asset(asset_id::obj_pal1_cursor, gba::base_obj_tile_addr(0));
 
       // Set-up base sprite
-      gba::dma3_copy(std::begin(obj_pal1::base), std::end(obj_pal1::base), start_base);
+      load_asset(asset_id::obj_pal1_base, start_base);
       const auto base_obj = gba::obj{127};
 
       {
@@ -330,27 +250,27 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
    };
 
    init_screen();
-   std::array<bool, 8> player_unit_present;
-
-   std::fill(player_unit_present.begin(), player_unit_present.end(), false);
-   combatant* moving_unit = nullptr;
-   combatant* attacking_unit = nullptr;
-   static_vector<pos, num_squares> move_tiles;
+   std::optional<unit_handle> moving_unit;
+   std::optional<unit_handle> attacking_unit;
+   auto& move_tiles = scene_new<static_vector<pos, num_squares>>(memory_hint::iwram);
    while (true) {
       const auto update_screen = [&]() {
-         static_vector<const combatant*, max_enemies + max_player_units_on_map + 1> combatant_pointers;
-         combatant_pointers.push_back(&cursor);
-         for (const auto& enemy : enemies) {
-            combatant_pointers.push_back(&enemy);
-         }
-         for (const auto& unit : player_units) {
-            combatant_pointers.push_back(&unit);
-         }
-
+         PROFILE_ZONE(update_screen);
          const auto i8 = [](auto val) { return static_cast<std::int8_t>(val); };
          cursor.x = std::clamp(cursor.x, i8(0), i8(map_info.map->width - 1));
          cursor.y = std::clamp(cursor.y, i8(0), i8(map_info.map->height - 1));
 
+         // The cursor is sorted along with the units so it has an entry too (with a slot of -1)
+         struct sprite_entry {
+            pos at;
+            std::int8_t slot;
+         };
+         static_vector<sprite_entry, battle_units::max_units + 1> sprites;
+         sprites.push_back({cursor, -1});
+         for (const auto unit : units.all()) {
+            sprites.push_back({units.position(unit), static_cast<std::int8_t>(unit.slot)});
+         }
+
          const auto old_cx = camera_x;
          const auto old_cy = camera_y;
 
@@ -359,35 +279,37 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
          display_sprite(map_info.base_x, map_info.base_y, 127, 0, -1);
 
          // sort combatants by y location to assign sprites to them
-         std::sort(combatant_pointers.begin(), combatant_pointers.end(), [](const auto& lhs, const auto& rhs) {
-            if (lhs->y == rhs->y) {
-               if (lhs->x == rhs->x) {
+         std::sort(sprites.begin(), sprites.end(), [](const auto& lhs, const auto& rhs) {
+            if (lhs.at.y == rhs.at.y) {
+               if (lhs.at.x == rhs.at.x) {
                   // this only happens for the cursor, which we always want to be lower priority
-                  return lhs->stats->class_ > rhs->stats->class_;
+                  return lhs.slot > rhs.slot;
                }
-               return lhs->x < rhs->x;
+               return lhs.at.x < rhs.at.x;
             }
-            return lhs->y > rhs->y;
+            return lhs.at.y > rhs.at.y;
          });
 
          // Assign objects to combatants (3 per combatant, the two extra are for HP bar and end indicator)
-         for (int i = 0; i < static_cast<int>(combatant_pointers.max_size()); ++i) {
+         for (int i = 0; i < static_cast<int>(sprites.max_size()); ++i) {
             using namespace gba::obj_opt;
             const auto end_obj = gba::obj{3 * i};
             const auto combatant_obj = gba::obj{1 + 3 * i};
             const auto health_bar_obj = gba::obj{2 + 3 * i};
-            const auto& cur_combatant = *combatant_pointers[i];
-            if (i >= std::ssize(combatant_pointers)) {
+            if (i >= std::ssize(sprites)) {
                // disable the sprite
                combatant_obj.set_attr0(gba::obj_attr0_options{}.set(display::disable).set(rot_scale::disable));
                end_obj.set_attr0(gba::obj_attr0_options{}.set(display::disable).set(rot_scale::disable));
                health_bar_obj.set_attr0(gba::obj_attr0_options{}.set(display::disable).set(rot_scale::disable));
                continue;
             }
-            const auto palette_no = class_data[cur_combatant.stats->class_].palette;
+            const auto at = sprites[i].at;
+            const auto is_cursor = sprites[i].slot < 0;
+            const auto unit = unit_handle{static_cast<std::uint8_t>(sprites[i].slot)};
+            const auto palette_no = class_data[is_cursor ? std::uint8_t{cursor_class} : units.class_of(unit)].palette;
             combatant_obj.set_tile_and_attr2(
-               cur_combatant.tile_no, gba::obj_attr2_options{}.set(palette_num{palette_no}));
-            if (cur_combatant.stats->class_ == cursor_class) {
+               is_cursor ? 0 : unit_tile_no(unit), gba::obj_attr2_options{}.set(palette_num{palette_no}));
+            if (is_cursor) {
                combatant_obj.set_attr0(gba::obj_attr0_options{}
                                           .set(display::enable)
                                           .set(mode::normal)
@@ -395,7 +317,7 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                                           .set(shape::square));
                combatant_obj.set_attr1(
                   gba::obj_attr1_options{}.set(size::s32x32).set(vflip::disable).set(hflip::disable));
-               display_sprite(cur_combatant.x, cur_combatant.y, 1 + 3 * i, 0, -17);
+               display_sprite(at.x, at.y, 1 + 3 * i, 0, -17);
             }
             else {
                combatant_obj.set_attr0(gba::obj_attr0_options{}
@@ -405,10 +327,10 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                                           .set(shape::vertical));
                combatant_obj.set_attr1(
                   gba::obj_attr1_options{}.set(size::v16x32).set(vflip::disable).set(hflip::disable));
-               display_sprite(cur_combatant.x, cur_combatant.y, 1 + 3 * i, 8, -24);
+               display_sprite(at.x, at.y, 1 + 3 * i, 8, -24);
             }
             // Display E above units that have acted
-            if (cur_combatant.acted) {
+            if (!is_cursor && units.has(unit, unit_flag::acted)) {
                end_obj.set_tile_and_attr2(end_sprite_loc_tile, gba::obj_attr2_options{}.set(palette_num::p1));
                end_obj.set_attr0(gba::obj_attr0_options{}
                                     .set(display::enable)
@@ -416,25 +338,22 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                                     .set(mosaic::disable)
                                     .set(shape::square));
                end_obj.set_attr1(gba::obj_attr1_options{}.set(size::s8x8).set(vflip::disable).set(hflip::disable));
-               display_sprite(cur_combatant.x, cur_combatant.y, 3 * i, 12, -32);
+               display_sprite(at.x, at.y, 3 * i, 12, -32);
             }
             else {
                end_obj.set_attr0(gba::obj_attr0_options{}.set(display::disable).set(rot_scale::disable));
             }
             // Health bars
-            if (cur_combatant.stats->class_ != cursor_class) {
+            if (!is_cursor) {
                const auto hp_tile_loc = max_enemies * 8 + max_player_units_on_map * 8 + 2 + i * 2;
                const auto hp_tile_write_loc = gba::base_obj_tile_addr(0) + hp_tile_loc * 8;
-               const auto hp_bar_val = static_cast<int>(16 * cur_combatant.stats->hp / cur_combatant.stats->max_hp);
+               // HP is kept below max_scaled_hp_mp so this can't overflow
+               const auto hp_bar_val = 16 * units.hp(unit) / units.max_hp(unit);
                const auto left_half = std::min(7, hp_bar_val);
                const auto right_half = std::clamp(hp_bar_val, 8, 15);
-               const auto palette = cur_combatant.is_enemy ? 2 : 1;
-               std::copy(
-                  &obj_pal1::health_bar[left_half * 8], &obj_pal1::health_bar[left_half * 8] + 8, hp_tile_write_loc);
-               std::copy(
-                  &obj_pal1::health_bar[right_half * 8],
-                  &obj_pal1::health_bar[right_half * 8] + 8,
-                  hp_tile_write_loc + 8);
+               const auto palette = units.is_enemy(unit) ? 2 : 1;
+               std::copy(&health_bar[left_half * 8], &health_bar[left_half * 8] + 8, hp_tile_write_loc);
+               std::copy(&health_bar[right_half * 8], &health_bar[right_half * 8] + 8, hp_tile_write_loc + 8);
                health_bar_obj.set_attr0(gba::obj_attr0_options{}
                                            .set(shape::horizontal)
                                            .set(display::enable)
@@ -443,7 +362,7 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                health_bar_obj.set_attr1(
                   gba::obj_attr1_options{}.set(size::h16x8).set(vflip::disable).set(hflip::disable));
                health_bar_obj.set_tile_and_attr2(hp_tile_loc, gba::obj_attr2_options{}.set(palette_num{palette}));
-               display_sprite(cur_combatant.x, cur_combatant.y, 3 * i + 2, 8, 5);
+               display_sprite(at.x, at.y, 3 * i + 2, 8, 5);
             }
             else {
                health_bar_obj.set_attr0(gba::obj_attr0_options{}.set(display::disable).set(rot_scale::disable));
@@ -457,25 +376,20 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
 
          const auto delta_x = camera_x - old_cx;
          const auto delta_y = camera_y - old_cy;
-         scroll_layer(camera_x, camera_y, map_info.map->high_priority_tiles.data(), bg2_screen_block, delta_x, delta_y);
-         scroll_layer(camera_x, camera_y, map_info.map->low_priority_tiles.data(), bg3_screen_block, delta_x, delta_y);
+         scroll_layer(camera_x, camera_y, map_info.map->high_priority_tiles, bg2_screen_block, delta_x, delta_y);
+         scroll_layer(camera_x, camera_y, map_info.map->low_priority_tiles, bg3_screen_block, delta_x, delta_y);
          scroll_layer(camera_x, camera_y, high_priority_buffer.data(), bg0_screen_block, delta_x, delta_y);
          scroll_layer(camera_x, camera_y, low_priority_buffer.data(), bg1_screen_block, delta_x, delta_y);
+         debug_layer::present();
       };
 
-      // check if the map is finished
-      bool won = true;
-      for (const auto& enemy : enemies) {
-         if (enemy.stats->hp > 0) {
-            won = false;
-            break;
-         }
-      }
-      if (won) {
+      // check if the map is finished (enemies are removed as soon as they're beaten)
+      if (units.enemies().empty()) {
          for (auto& unit : save_data.characters) {
             unit.deployed = false;
             unit.fully_heal();
          }
+         battle_telemetry::battle_ended(battle_telemetry::battle_result::won, save_data.frame_count);
          return true;
       }
 
@@ -487,11 +401,11 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
          }
       }
       if (lost) {
+         journal.rollback();
+         battle_telemetry::battle_ended(battle_telemetry::battle_result::lost, save_data.frame_count);
          return false;
       }
 
-      const auto matches_cursor_loc = [&](const auto& obj) { return cursor.x == obj.x && cursor.y == obj.y; };
-
       const auto& keypad = wait_vblank_and_update(save_data);
 
       if (keypad.left_repeat()) {
@@ -508,8 +422,8 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
       }
 
       const auto finish_or_cancel_move = [&]() {
-         moving_unit = nullptr;
-         attacking_unit = nullptr;
+         moving_unit.reset();
+         attacking_unit.reset();
          gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
          gba::dma3_fill(bg1_tiles, bg1_tiles + 32 * 32, blank_tile);
          gba::dma3_fill(low_priority_buffer.begin(), low_priority_buffer.end(), blank_tile);
@@ -517,7 +431,7 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
          update_screen();
       };
 
-      const auto player_unit_menu = [&](combatant& unit, int default_option = 0) {
+      const auto player_unit_menu = [&](unit_handle unit, int default_option = 0) {
          constexpr std::array<const char*, 2> options{"Move", "Attack"};
          gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
          init_screen();
@@ -526,16 +440,19 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
          const auto choice = menu(save_data, options, 0, 0, default_option, true);
          gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
          if (choice == 0) {
-            moving_unit = &unit;
-            move_tiles = find_path(
-               unit.start_x, unit.start_y, unit.stats->bases.move, unit.stats->bases.jump, map_info, enemies);
+            moving_unit = unit;
+            const auto start = units.start(unit);
+            const auto& bases = units.stats(unit).bases;
+            move_tiles
+               = timed_find_path(start, bases.move, bases.jump, map_info, units.positions_of(units.enemies()));
             fill_move_buffers(map_info, 2, move_tiles, low_priority_buffer, high_priority_buffer);
          }
          else if (choice == 1) {
-            attacking_unit = &unit;
-            move_tiles = find_path(unit.x, unit.y, 1, 99, map_info, {});
+            attacking_unit = unit;
+            const auto at = units.position(unit);
+            move_tiles = timed_find_path(at, 1, 99, map_info, {});
             // remove the unit's tile
-            const auto remove_loc = std::find(move_tiles.begin(), move_tiles.end(), pos{unit.x, unit.y});
+            const auto remove_loc = std::find(move_tiles.begin(), move_tiles.end(), at);
             if (remove_loc != move_tiles.end()) {
                move_tiles.erase(remove_loc);
             }
@@ -553,30 +470,31 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
          gba::bg0.set_scroll(0, 0);
          const auto choice = menu(save_data, options, 0, 0, 0, true);
          gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
-         if (choice == 0 && player_units.size() > 0) {
-            for (auto& unit : player_units) {
-               unit.acted = false;
-               unit.moved = false;
-               unit.start_x = unit.x;
-               unit.start_y = unit.y;
+         if (choice == 0 && !units.players().empty()) {
+            for (const auto unit : units.players()) {
+               units.set(unit, unit_flag::acted, false);
+               units.set(unit, unit_flag::moved, false);
+               units.start(unit) = units.position(unit);
             }
+            battle_telemetry::phase_started(battle_telemetry::phase::enemy, save_data.frame_count);
             // Enemy turn
-            for (auto& enemy : enemies) {
-               cursor.x = enemy.x;
-               cursor.y = enemy.y;
+            for (const auto enemy : units.enemies()) {
+               PROFILE_ZONE(enemy_ai);
+               cursor = units.position(enemy);
                update_screen();
                // If there are no enemies don't move
-               if (player_units.empty()) {
+               if (units.players().empty()) {
                   continue;
                }
-               move_tiles = find_path(
-                  enemy.x, enemy.y, enemy.stats->bases.move, enemy.stats->bases.jump, map_info, player_units);
+               const auto& bases = units.stats(enemy).bases;
+               move_tiles
+                  = timed_find_path(cursor, bases.move, bases.jump, map_info, units.positions_of(units.players()));
                // remove any panels that already have an enemy unit on them
-               for (const auto& enemy2 : enemies) {
-                  if (&enemy == &enemy2) {
+               for (const auto enemy2 : units.enemies()) {
+                  if (enemy == enemy2) {
                      continue;
                   }
-                  const auto iter = std::find(move_tiles.begin(), move_tiles.end(), pos{enemy2.x, enemy2.y});
+                  const auto iter = std::find(move_tiles.begin(), move_tiles.end(), units.position(enemy2));
                   if (iter != move_tiles.end()) {
                      move_tiles.erase(iter);
                   }
@@ -588,44 +506,53 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                }
                // try to attack the closest unit to the starting location
                const auto dist = [](int x1, int y1, int x2, int y2) { return std::abs(x2 - x1) + std::abs(y2 - y1); };
-               auto closest_unit = [&]() {
-                  const auto comp = [&](const auto& u1, const auto& u2) {
-                     const auto dist1 = dist(u1.x, u1.y, enemy.x, enemy.y);
-                     const auto dist2 = dist(u2.x, u2.y, enemy.x, enemy.y);
-                     return dist1 < dist2;
+               const auto enemy_at = units.position(enemy);
+               const auto closest_unit = [&]() {
+                  const auto dist_to_enemy = [&](unit_handle unit) {
+                     const auto at = units.position(unit);
+                     return dist(at.x, at.y, enemy_at.x, enemy_at.y);
                   };
-                  return std::min_element(player_units.begin(), player_units.end(), comp);
+                  auto closest = units.players().front();
+                  for (const auto unit : units.players()) {
+                     if (dist_to_enemy(unit) < dist_to_enemy(closest)) {
+                        closest = unit;
+                     }
+                  }
+                  return closest;
                }();
+               const auto target_at = units.position(closest_unit);
                // Find the panel that's the closest to that unit
                const auto& closest_panel = [&]() {
                   const auto comp = [&](const auto& u1, const auto& u2) {
-                     const auto dist1 = dist(u1.x, u1.y, closest_unit->x, closest_unit->y);
-                     const auto dist2 = dist(u2.x, u2.y, closest_unit->x, closest_unit->y);
+                     const auto dist1 = dist(u1.x, u1.y, target_at.x, target_at.y);
+                     const auto dist2 = dist(u2.x, u2.y, target_at.x, target_at.y);
                      return dist1 < dist2;
                   };
                   return *std::min_element(move_tiles.begin(), move_tiles.end(), comp);
                }();
-               enemy.x = closest_panel.x;
-               enemy.y = closest_panel.y;
-               cursor.x = closest_panel.x;
-               cursor.y = closest_panel.y;
-               enemy.acted = true;
+               record_move(enemy, enemy_at, closest_panel);
+               units.position(enemy) = closest_panel;
+               cursor = closest_panel;
+               units.set(enemy, unit_flag::acted);
                // if one tile away we can attack
-               if (dist(enemy.x, enemy.y, closest_unit->x, closest_unit->y) == 1) {
-                  const auto damage = calc_normal_damage(*enemy.stats, *closest_unit->stats);
-                  closest_unit->stats->hp -= damage;
-                  if (closest_unit->stats->hp <= 0) {
-                     player_units.erase(closest_unit);
+               if (dist(closest_panel.x, closest_panel.y, target_at.x, target_at.y) == 1) {
+                  const auto damage = calc_normal_damage(units.stats(enemy), units.stats(closest_unit));
+                  journal.record(units.stats(closest_unit));
+                  units.take_damage(closest_unit, damage);
+                  record_attack(units, enemy, closest_unit, damage);
+                  if (units.hp(closest_unit) <= 0) {
+                     units.remove(closest_unit);
                   }
                }
             }
-            for (auto& enemy : enemies) {
-               enemy.acted = false;
+            for (const auto enemy : units.enemies()) {
+               units.set(enemy, unit_flag::acted, false);
             }
+            battle_telemetry::phase_started(battle_telemetry::phase::player, save_data.frame_count);
             // Set the cursor to the first player unit
-            const auto& front = player_units.front();
-            cursor.x = front.x;
-            cursor.y = front.y;
+            if (!units.players().empty()) {
+               cursor = units.position(units.players().front());
+            }
             update_screen();
          }
          else if (choice == 1) {
@@ -633,94 +560,76 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
             const auto choice2 = menu(save_data, options2, 0, 0, 0, true);
             gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
             if (choice2 == 1) {
+               journal.rollback();
+               battle_telemetry::battle_ended(battle_telemetry::battle_result::gave_up, save_data.frame_count);
                return false;
             }
          }
          return true;
       };
 
+      const auto base = pos{map_info.base_x, map_info.base_y};
+
       if (keypad.b_pressed()) {
-         const auto player_iter = std::find_if(player_units.begin(), player_units.end(), matches_cursor_loc);
-         if (moving_unit != nullptr) {
-            cursor.x = moving_unit->x;
-            cursor.y = moving_unit->y;
-            auto& unit = *moving_unit;
+         const auto player_at_cursor = units.find_at(units.players(), cursor);
+         if (moving_unit) {
+            const auto unit = *moving_unit;
+            cursor = units.position(unit);
             finish_or_cancel_move();
-            unit.moved = false;
+            units.set(unit, unit_flag::moved, false);
             player_unit_menu(unit);
          }
-         else if (attacking_unit != nullptr) {
-            cursor.x = attacking_unit->x;
-            cursor.y = attacking_unit->y;
-            auto& unit = *attacking_unit;
+         else if (attacking_unit) {
+            const auto unit = *attacking_unit;
+            cursor = units.position(unit);
             finish_or_cancel_move();
             player_unit_menu(unit, 1);
          }
-         else if (player_iter != player_units.end()) {
-            auto& unit = *player_iter;
+         else if (player_at_cursor) {
+            const auto unit = *player_at_cursor;
+            const auto start = units.start(unit);
             // prohibit canceling if there's a unit at the starting loc
-            const auto iter2 = std::find_if(player_units.begin(), player_units.end(), [&](const auto& p) {
-               return p.x == unit.start_x && p.y == unit.start_y;
-            });
-            if (iter2 == player_units.end()) {
-               if (
-                  unit.start_x == map_info.base_x && unit.start_y == map_info.base_y && unit.start_x == unit.x
-                  && unit.start_y == unit.y) {
+            if (!units.find_at(units.players(), start)) {
+               if (start == base && start == units.position(unit)) {
                   // Stuff them back into the base
-                  player_unit_present[unit.index] = false;
-                  unit.stats->deployed = false;
-                  player_units.erase(player_iter);
+                  journal.record(units.stats(unit));
+                  units.stats(unit).deployed = false;
+                  units.remove(unit);
                }
-               else if (unit.moved && !unit.acted) {
-                  unit.x = unit.start_x;
-                  unit.y = unit.start_y;
-                  cursor.x = unit.start_x;
-                  cursor.y = unit.start_y;
-                  unit.moved = false;
+               else if (units.has(unit, unit_flag::moved) && !units.has(unit, unit_flag::acted)) {
+                  units.position(unit) = start;
+                  cursor = start;
+                  units.set(unit, unit_flag::moved, false);
                }
             }
          }
       }
       else if (keypad.l_pressed()) {
-         const auto enemy_iter = std::find_if(enemies.begin(), enemies.end(), matches_cursor_loc);
-         const auto player_iter = std::find_if(player_units.begin(), player_units.end(), matches_cursor_loc);
-         if (enemy_iter != enemies.end()) {
-            gba::bg0.set_scroll(0, 0);
-            const auto enemy_span = std::span<character>(enemy_iter->stats, enemy_iter->stats + 1);
-            display_stats(save_data, enemy_span, 0, false);
-            init_screen();
-            gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
-         }
-         else if (player_iter != player_units.end()) {
+         if (const auto unit = units.find_at(units.all(), cursor)) {
             gba::bg0.set_scroll(0, 0);
-            const auto index = std::distance(player_units.begin(), player_iter);
-            const auto& unit = player_units[index];
-            // Very hack-ish fix to show just the selected member
-            const auto char_span = std::span<character>{unit.stats, unit.stats + 1};
-            display_stats(save_data, char_span, 0, false);
+            // Very hack-ish fix to show just the selected unit
+            display_stats(save_data, std::span<character>{&units.stats(*unit), 1}, 0, false);
             init_screen();
             gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
          }
       }
       else if (keypad.a_pressed()) {
-         const auto player_iter = std::find_if(player_units.begin(), player_units.end(), matches_cursor_loc);
-         if (moving_unit != nullptr) {
+         const auto player_at_cursor = units.find_at(units.players(), cursor);
+         if (moving_unit) {
             // Don't allow moving on top of other units (this also prohibits moving to own panel)
-            if (player_iter == player_units.end()) {
-               const auto move_to = pos{cursor.x, cursor.y};
+            if (!player_at_cursor) {
+               const auto move_to = cursor;
                if (std::find(move_tiles.begin(), move_tiles.end(), move_to) != move_tiles.end()) {
-                  moving_unit->x = move_to.x;
-                  moving_unit->y = move_to.y;
-                  moving_unit->moved = true;
-                  auto& unit = *moving_unit;
+                  const auto unit = *moving_unit;
+                  record_move(unit, units.position(unit), move_to);
+                  units.position(unit) = move_to;
+                  units.set(unit, unit_flag::moved);
                   finish_or_cancel_move();
-                  if (unit.x == map_info.base_x && unit.y == map_info.base_y) {
+                  if (move_to == base) {
                      // if moved into the base put the character away
-                     player_unit_present[unit.index] = false;
-                     unit.stats->deployed = false;
-                     const auto player_iter = std::find_if(
-                        player_units.begin(), player_units.end(), [&](const auto& value) { return &value == &unit; });
-                     player_units.erase(player_iter);
+                     journal.record(units.stats(unit));
+                     units.stats(unit).deployed = false;
+                     units.remove(unit);
                   }
                   // else {
                   //    player_unit_menu(unit);
@@ -728,30 +637,36 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                }
             }
          }
-         else if (attacking_unit != nullptr) {
-            if (std::ranges::find(move_tiles, pos{cursor.x, cursor.y}) != move_tiles.end()) {
-               const auto enemy_iter = std::find_if(enemies.begin(), enemies.end(), matches_cursor_loc);
-               if (enemy_iter != enemies.end()) {
-                  attacking_unit->acted = true;
-                  const auto damage = calc_normal_damage(*attacking_unit->stats, *enemy_iter->stats);
-                  enemy_iter->stats->hp -= damage;
-                  if (enemy_iter->stats->hp <= 0) {
-                     if (enemy_iter->is_boss) {
-                        attacking_unit->stats->exp += enemy_iter->stats->level * 300;
+         else if (attacking_unit) {
+            if (std::ranges::find(move_tiles, cursor) != move_tiles.end()) {
+               if (const auto enemy = units.find_at(units.enemies(), cursor)) {
+                  const auto unit = *attacking_unit;
+                  auto& attacker = units.stats(unit);
+                  units.set(unit, unit_flag::acted);
+                  const auto damage = calc_normal_damage(attacker, units.stats(*enemy));
+                  units.take_damage(*enemy, damage);
+                  record_attack(units, unit, *enemy, damage);
+                  if (units.hp(*enemy) <= 0) {
+                     journal.record(attacker);
+                     const auto enemy_level = units.stats(*enemy).level;
+                     if (units.has(*enemy, unit_flag::boss)) {
+                        attacker.exp = sat_add(attacker.exp, sat_mul(enemy_level, 300));
                      }
                      else {
-                        attacking_unit->stats->exp += enemy_iter->stats->level * 30;
+                        attacker.exp = sat_add(attacker.exp, sat_mul(enemy_level, 30));
                      }
-                     attacking_unit->stats->level_up_if_needed();
-                     enemies.erase(enemy_iter);
+                     // Levelling up changes max HP
+                     attacker.level_up_if_needed();
+                     units.refresh_hp(unit);
+                     units.remove(*enemy);
                   }
                   finish_or_cancel_move();
                }
             }
          }
-         else if (player_iter != player_units.end()) {
-            if (!player_iter->acted) {
-               player_unit_menu(*player_iter);
+         else if (player_at_cursor) {
+            if (!units.has(*player_at_cursor, unit_flag::acted)) {
+               player_unit_menu(*player_at_cursor);
             }
             else {
                if (!start_menu()) {
@@ -759,7 +674,7 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                }
             }
          }
-         else if (cursor.x == map_info.base_x && cursor.y == map_info.base_y) {
+         else if (cursor == base) {
             static_vector<const char*, max_characters> char_names;
             static_vector<character*, max_characters> char_mapping;
             for (auto& char_ : save_data.characters) {
@@ -769,28 +684,16 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
                }
             }
             if (char_names.size() > 0) {
-               if (player_units.size() != max_player_units_on_map) {
+               if (units.players().size() != max_player_units_on_map) {
                   gba::bg0.set_scroll(0, 0);
                   gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
                   const auto choice = menu(save_data, char_names, 0, 0, 0, true);
                   if (choice != -1) {
-                     player_units.push_back({});
-                     auto& new_unit = player_units.back();
-                     new_unit.x = map_info.base_x;
-                     new_unit.y = map_info.base_y;
-                     new_unit.start_x = map_info.base_x;
-                     new_unit.start_y = map_info.base_y;
-                     new_unit.stats = char_mapping[choice];
+                     journal.record(*char_mapping[choice]);
                      char_mapping[choice]->deployed = true;
-                     const auto index_loc = std::find(player_unit_present.begin(), player_unit_present.end(), false);
-                     *index_loc = true;
-                     const auto index = std::distance(player_unit_present.begin(), index_loc);
-                     new_unit.index = index;
-                     const auto& tile_data = class_data[char_mapping[choice]->class_].sprite;
-                     const auto tile_no = start_tile_offset + max_enemies * 8 + index * 8;
-                     const auto write_loc = gba::base_obj_tile_addr(0) + tile_no * 8;
-                     new_unit.tile_no = tile_no;
-                     gba::dma3_copy(std::begin(tile_data), std::end(tile_data), write_loc);
+                     const auto new_unit = units.add_player(*char_mapping[choice], base);
+                     const auto write_loc = gba::base_obj_tile_addr(0) + unit_tile_no(new_unit) * 8;
+                     load_asset(class_data[char_mapping[choice]->class_].sprite, write_loc);
                      gba::dma3_fill(bg0_tiles, bg0_tiles + 32 * 32, blank_tile);
                      init_screen();
                      update_screen();
@@ -809,7 +712,7 @@ bool do_battle(file_save_data& save_data, const full_map_info& map_info, int ene
          }
       }
       else if (keypad.start_pressed()) {
-         if (moving_unit == nullptr) {
+         if (!moving_unit) {
             if (!start_menu()) {
                return false;
             }
@@ -3,6 +3,12 @@
 
 #include "map_data.hpp"
 
-bool do_battle(file_save_data& save_data, const full_map_info& map_info, int enemy_strength) noexcept;
+#include <cstdint>
+
+// Returns true if the map is beaten
+// If it's lost (or exited) the characters are put back how they were before the battle
+// All of the battle's randomness comes from seed, so the same seed and inputs give the same battle
+bool do_battle(
+   file_save_data& save_data, const full_map_info& map_info, int enemy_strength, std::uint32_t seed) noexcept;
 
 #endif // BATTLE_HPP
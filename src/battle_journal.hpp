@@ -0,0 +1,85 @@
+#ifndef BATTLE_JOURNAL_HPP
+#define BATTLE_JOURNAL_HPP
+
+#include "data.hpp"
+#include "gba.hpp"
+#include "save_data.hpp"
+#include "static_vector.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Records the state of each character a battle changes so that losing can undo it
+// Only the fields a battle can change are kept (and only for characters that are changed), which is
+// much smaller than keeping a copy of the whole file
+class battle_journal {
+public:
+   explicit battle_journal(std::array<character, max_characters>& characters) noexcept : characters{characters} {}
+
+   // Must be called before char_ is changed; only the first call for each character records anything
+   void record(const character& char_) noexcept
+   {
+      const auto index = &char_ - characters.data();
+      GBA_ASSERT(index >= 0 && index < max_characters);
+      if (recorded[index]) {
+         return;
+      }
+      recorded[index] = true;
+      entries.push_back(
+         {static_cast<std::uint8_t>(index),
+          char_.deployed,
+          char_.level,
+          char_.exp,
+          {char_.attack, char_.defense, char_.m_attack, char_.m_defense, char_.speed, char_.hit},
+          char_.hp,
+          char_.max_hp,
+          char_.mp,
+          char_.max_mp,
+          char_.hp_mp_shift});
+   }
+
+   // Puts every recorded character back how it was before the battle
+   // (Each character has at most one entry so the order doesn't matter)
+   void rollback() const noexcept
+   {
+      for (const auto& entry : entries) {
+         auto& char_ = characters[entry.index];
+         char_.deployed = entry.deployed;
+         char_.level = entry.level;
+         char_.exp = entry.exp;
+         char_.attack = entry.stats[0];
+         char_.defense = entry.stats[1];
+         char_.m_attack = entry.stats[2];
+         char_.m_defense = entry.stats[3];
+         char_.speed = entry.stats[4];
+         char_.hit = entry.stats[5];
+         char_.hp = entry.hp;
+         char_.max_hp = entry.max_hp;
+         char_.mp = entry.mp;
+         char_.max_mp = entry.max_mp;
+         char_.hp_mp_shift = entry.hp_mp_shift;
+      }
+   }
+
+private:
+   // HP and deployment change during the battle; the rest change when levelling up
+   // (MP is only here because a new HP/MP shift rescales it)
+   struct entry {
+      std::uint8_t index;
+      bool deployed;
+      std::int32_t level;
+      std::int32_t exp;
+      std::array<std::int32_t, 6> stats;
+      std::int32_t hp;
+      std::int32_t max_hp;
+      std::int32_t mp;
+      std::int32_t max_mp;
+      std::uint8_t hp_mp_shift;
+   };
+
+   std::array<character, max_characters>& characters;
+   static_vector<entry, max_characters> entries;
+   std::array<bool, max_characters> recorded{};
+};
+
+#endif // BATTLE_JOURNAL_HPP
@@ -0,0 +1,122 @@
+#include "battle_telemetry.hpp"
+
+#include "gba.hpp"
+#include "perf_run.hpp"
+#include "save_data.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+using namespace battle_telemetry;
+
+constexpr int ring_size = 512;
+
+GBA_EWRAM_BSS std::array<event, ring_size> ring;
+// Every event recorded since boot; the ring holds the last ring_size of them
+std::uint32_t num_recorded = 0;
+
+std::uint64_t battle_start_frame = 0;
+int turn = 0;
+bool in_phase = false;
+phase current_phase = phase::player;
+std::uint64_t phase_start_frame = 0;
+std::uint32_t phase_start_cycles = 0;
+
+void end_phase(std::uint64_t frame_count) noexcept
+{
+   if (!in_phase) {
+      return;
+   }
+   const auto frames
+      = std::min<std::uint64_t>(frame_count - phase_start_frame, std::numeric_limits<std::uint16_t>::max());
+   record(event_type::phase_end, static_cast<int>(current_phase), frames, gba::cycle_count() - phase_start_cycles);
+   in_phase = false;
+}
+
+#if defined(PEKMUN2_TELEMETRY_SRAM) || defined(PEKMUN2_PERF_RUN)
+
+// SRAM copy of the ring, rewritten at the end of each battle:
+//    char magic[4]        'P', 'K', 'T', '1'
+//    u16 num_events
+//    u16 unused
+//    u32 dropped          events recorded since boot that didn't fit in the ring
+//    followed by num_events events, oldest first
+// It's in the last file slot, which these builds don't offer for saving (see num_usable_file_slots), between the
+// perf run's input script and report (see perf_run.hpp)
+constexpr int sram_offset = 0x6000;
+
+struct sram_header {
+   std::array<char, 4> magic;
+   std::uint16_t num_events;
+   std::uint16_t unused;
+   std::uint32_t dropped;
+};
+
+constexpr int sram_size = sizeof(sram_header) + ring_size * sizeof(event);
+// Clear of every slot the game can save to
+static_assert(sram_offset >= file_slot_offset(num_usable_file_slots));
+static_assert(sram_offset + sram_size <= save_data_end);
+static_assert(sram_offset >= perf_run::input_offset + perf_run::input_size);
+static_assert(sram_offset + sram_size <= perf_run::report_offset);
+
+void save_to_sram() noexcept
+{
+   const auto loc = gba::sram_addr() + sram_offset;
+   const auto num_events = std::min<std::uint32_t>(num_recorded, ring_size);
+   const auto first = num_recorded - num_events;
+   for (std::uint32_t i = 0; i < num_events; ++i) {
+      sram_write(ring[(first + i) % ring_size], loc + sizeof(sram_header) + i * sizeof(event));
+   }
+   sram_write(sram_header{{'P', 'K', 'T', '1'}, static_cast<std::uint16_t>(num_events), 0, first}, loc);
+}
+
+#else
+
+void save_to_sram() noexcept {}
+
+#endif
+
+} // anonymous namespace
+
+namespace battle_telemetry {
+
+void record(event_type type, int arg0, int arg1, std::uint32_t value) noexcept
+{
+   ring[num_recorded % ring_size]
+      = event{type, static_cast<std::uint8_t>(arg0), static_cast<std::uint16_t>(arg1), value};
+   ++num_recorded;
+}
+
+void battle_started(int map_number, int enemy_strength, std::uint32_t seed, std::uint64_t frame_count) noexcept
+{
+   record(event_type::battle_start, map_number, enemy_strength, seed);
+   battle_start_frame = frame_count;
+   turn = 0;
+   phase_started(phase::player, frame_count);
+}
+
+void battle_ended(battle_result result, std::uint64_t frame_count) noexcept
+{
+   end_phase(frame_count);
+   record(event_type::battle_end, static_cast<int>(result), turn, frame_count - battle_start_frame);
+   save_to_sram();
+}
+
+void phase_started(phase new_phase, std::uint64_t frame_count) noexcept
+{
+   end_phase(frame_count);
+   if (new_phase == phase::player) {
+      ++turn;
+   }
+   record(event_type::phase_start, static_cast<int>(new_phase), turn, 0);
+   in_phase = true;
+   current_phase = new_phase;
+   phase_start_frame = frame_count;
+   phase_start_cycles = gba::cycle_count();
+}
+
+} // namespace battle_telemetry
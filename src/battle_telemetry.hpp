@@ -0,0 +1,68 @@
+#ifndef BATTLE_TELEMETRY_HPP
+#define BATTLE_TELEMETRY_HPP
+
+#include "pathfinding.hpp"
+
+#include <cstdint>
+
+// Records what happens in each battle as a stream of 8-byte events in an EWRAM ring (the last 512 events are kept)
+// so slow turns can be traced back to the map, enemy strength and turn they happened on
+// With PEKMUN2_TELEMETRY_SRAM defined (and in perf runs) the ring is also copied to SRAM at the end of each battle,
+// over the last file slot; scripts/decode_telemetry.py turns it into per-battle timelines and totals
+namespace battle_telemetry {
+
+// What arg0, arg1 and value hold for each event; positions are packed as x << 8 | y
+enum struct event_type : std::uint8_t {
+   // map number, enemy strength, seed
+   battle_start,
+   // result (0 lost, 1 won, 2 gave up), turns, frames the battle took
+   battle_end,
+   // phase (0 player, 1 enemy), turn, unused
+   phase_start,
+   // phase, frames the phase took, cycles the phase took
+   phase_end,
+   // unit slot, to, from
+   unit_move,
+   // attacker slot, defender slot, damage | defender's HP afterwards << 16
+   attack,
+   // unit slot, unused, unused
+   death,
+   // tiles found, move << 8 | jump, cycles
+   find_path,
+};
+
+enum struct battle_result : std::uint8_t {
+   lost,
+   won,
+   gave_up
+};
+
+enum struct phase : std::uint8_t {
+   player,
+   enemy
+};
+
+struct event {
+   event_type type;
+   std::uint8_t arg0;
+   std::uint16_t arg1;
+   std::uint32_t value;
+};
+static_assert(sizeof(event) == 8);
+
+void record(event_type type, int arg0, int arg1, std::uint32_t value) noexcept;
+
+// These keep track of the turn and of when the battle and the current phase started
+// frame_count is the save's frame counter, which wait_vblank_and_update advances
+void battle_started(int map_number, int enemy_strength, std::uint32_t seed, std::uint64_t frame_count) noexcept;
+void battle_ended(battle_result result, std::uint64_t frame_count) noexcept;
+void phase_started(phase new_phase, std::uint64_t frame_count) noexcept;
+
+inline std::uint16_t pack(pos at) noexcept
+{
+   return static_cast<std::uint16_t>(static_cast<std::uint8_t>(at.x) << 8 | static_cast<std::uint8_t>(at.y));
+}
+
+} // namespace battle_telemetry
+
+#endif // BATTLE_TELEMETRY_HPP
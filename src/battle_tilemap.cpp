@@ -0,0 +1,138 @@
+#include "battle_tilemap.hpp"
+
+#include "common_funcs.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+const auto tile_at = [](const std::uint16_t* layer_data, unsigned x, unsigned y) {
+   if (x >= tilemap_width || y >= tilemap_height) {
+      return gba::make_tile(blank_tile, 1);
+   }
+   else {
+      return layer_data[x + y * 60];
+   }
+};
+
+} // anonymous namespace
+
+GBA_IWRAM_OVERLAY_CODE(BATTLE_OVERLAY) void redraw_layer(
+   int camera_x, int camera_y, const std::uint16_t* layer_data, gba::bg_opt::screen_base_block loc) noexcept
+{
+   // If the camera is negative we need to subtract 7 to make sure we're updating
+   // the tile that's showing at the edge
+   const auto offset_x = camera_x < 0 ? (camera_x - 7) / 8 : camera_x / 8;
+   const auto offset_y = camera_y < 0 ? (camera_y - 7) / 8 : camera_y / 8;
+   for (int y = 0; y != 21; ++y) {
+      const unsigned tile_y = y + offset_y;
+      for (int x = 0; x != 31; ++x) {
+         const unsigned tile_x = x + offset_x;
+         *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
+      }
+   }
+}
+
+GBA_IWRAM_OVERLAY_CODE(BATTLE_OVERLAY) void scroll_layer(
+   int camera_x,
+   int camera_y,
+   const std::uint16_t* layer_data,
+   gba::bg_opt::screen_base_block loc,
+   int delta_x,
+   int delta_y) noexcept
+{
+   PROFILE_ZONE(scroll_layer);
+   const auto offset_x = camera_x < 0 ? (camera_x - 7) / 8 : camera_x / 8;
+   const auto offset_y = camera_y < 0 ? (camera_y - 7) / 8 : camera_y / 8;
+   // TODO: Is there a more compact way to represent this?
+   if (delta_x < 0) {
+      const auto x_scroll_amount = std::min(std::abs(delta_x - 7) / 8, 31);
+      for (int x = 0; x != x_scroll_amount; ++x) {
+         const unsigned tile_x = x + offset_x;
+         for (int y = 0; y != 21; ++y) {
+            const unsigned tile_y = y + offset_y;
+            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
+         }
+      }
+   }
+   else if (delta_x > 0) {
+      const auto x_scroll_amount = std::min((delta_x + 7) / 8, 31);
+      for (int x = 31 - x_scroll_amount; x != 31; ++x) {
+         const unsigned tile_x = x + offset_x;
+         for (int y = 0; y != 21; ++y) {
+            const unsigned tile_y = y + offset_y;
+            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
+         }
+      }
+   }
+   if (delta_y < 0) {
+      const auto y_scroll_amount = std::min(std::abs(delta_y - 7) / 8, 21);
+      for (int y = 0; y != y_scroll_amount; ++y) {
+         const unsigned tile_y = y + offset_y;
+         for (int x = 0; x != 31; ++x) {
+            const unsigned tile_x = x + offset_x;
+            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
+         }
+      }
+   }
+   else if (delta_y > 0) {
+      const auto y_scroll_amount = std::min((delta_y + 7) / 8, 21);
+      for (int y = 21 - y_scroll_amount; y != 21; ++y) {
+         const unsigned tile_y = y + offset_y;
+         for (int x = 0; x != 31; ++x) {
+            const unsigned tile_x = x + offset_x;
+            *bg_screen_loc_at(loc, tile_x % 32, tile_y % 32) = tile_at(layer_data, tile_x, tile_y);
+         }
+      }
+   }
+}
+
+void fill_move_buffers(const full_map_info& map_info,
+   int palette_num,
+   const static_vector<pos, num_squares>& tiles,
+   tilemap_buffer& low_priority_buffer,
+   tilemap_buffer& high_priority_buffer) noexcept
+{
+   for (const auto& tile : tiles) {
+      auto& buffer
+         = map_info.map->tile_is_high_priority_at(tile.x, tile.y) ? high_priority_buffer : low_priority_buffer;
+      const auto tile_x = tile.x * 2 + tile.y * 2;
+      const auto tile_y = map_info.map->y_offset + tile.y - tile.x - map_info.map->height_at(tile.x, tile.y);
+      // This is really messy/bad but it works so oh well
+      constexpr auto start_move_indic = tile_locs::start_move_indic;
+      if (buffer[tile_x + tile_y * tilemap_width] == blank_tile) {
+         buffer[tile_x + 0 + tile_y * tilemap_width] = gba::make_tile(start_move_indic, palette_num);
+         buffer[tile_x + 1 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 1, palette_num);
+      }
+      else {
+         buffer[tile_x + 0 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 8, palette_num);
+         buffer[tile_x + 1 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 9, palette_num);
+      }
+      if (buffer[tile_x + 2 + tile_y * tilemap_width] == blank_tile) {
+         buffer[tile_x + 2 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 2, palette_num);
+         buffer[tile_x + 3 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 3, palette_num);
+      }
+      else {
+         buffer[tile_x + 2 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 10, palette_num);
+         buffer[tile_x + 3 + tile_y * tilemap_width] = gba::make_tile(start_move_indic + 11, palette_num);
+      }
+      if (buffer[tile_x + (tile_y + 1) * tilemap_width] == blank_tile) {
+         buffer[tile_x + 0 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 4, palette_num);
+         buffer[tile_x + 1 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 5, palette_num);
+      }
+      else {
+         buffer[tile_x + 0 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 10, palette_num);
+         buffer[tile_x + 1 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 11, palette_num);
+      }
+      if (buffer[tile_x + 2 + (tile_y + 1) * tilemap_width] == blank_tile) {
+         buffer[tile_x + 2 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 6, palette_num);
+         buffer[tile_x + 3 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 7, palette_num);
+      }
+      else {
+         buffer[tile_x + 2 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 8, palette_num);
+         buffer[tile_x + 3 + (tile_y + 1) * tilemap_width] = gba::make_tile(start_move_indic + 9, palette_num);
+      }
+   }
+}
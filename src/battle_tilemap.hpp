@@ -0,0 +1,49 @@
+#ifndef BATTLE_TILEMAP_HPP
+#define BATTLE_TILEMAP_HPP
+
+#include "constants.hpp"
+#include "gba.hpp"
+#include "map_data.hpp"
+#include "overlay.hpp"
+#include "pathfinding.hpp"
+#include "static_vector.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Composes the battle's tilemaps: the map layers plus the move/attack indicators, copied to the 32x32 screen blocks
+// as the camera moves
+
+inline constexpr auto blank_tile = tile_locs::start_tileset + 17;
+
+// Where the battle puts each background's tilemap
+inline constexpr auto bg0_screen_block = gba::bg_opt::screen_base_block::b62;
+inline constexpr auto bg1_screen_block = gba::bg_opt::screen_base_block::b60;
+inline constexpr auto bg2_screen_block = gba::bg_opt::screen_base_block::b58;
+inline constexpr auto bg3_screen_block = gba::bg_opt::screen_base_block::b56;
+
+// A whole map layer; 60x40 tiles
+using tilemap_buffer = std::array<std::uint16_t, tilemap_width * tilemap_height>;
+
+// The layer updates run every time the camera moves so they're in the battle overlay
+// Copies the part of the layer the camera can see to the screen block
+GBA_IWRAM_OVERLAY_CODE(BATTLE_OVERLAY) void redraw_layer(
+   int camera_x, int camera_y, const std::uint16_t* layer_data, gba::bg_opt::screen_base_block loc) noexcept;
+
+// Copies only the rows/columns that came into view after the camera moved by (delta_x, delta_y)
+GBA_IWRAM_OVERLAY_CODE(BATTLE_OVERLAY) void scroll_layer(
+   int camera_x,
+   int camera_y,
+   const std::uint16_t* layer_data,
+   gba::bg_opt::screen_base_block loc,
+   int delta_x,
+   int delta_y) noexcept;
+
+// Draws the move indicator (in palette_num) for each tile into whichever buffer the tile's priority needs
+void fill_move_buffers(const full_map_info& map_info,
+   int palette_num,
+   const static_vector<pos, num_squares>& tiles,
+   tilemap_buffer& low_priority_buffer,
+   tilemap_buffer& high_priority_buffer) noexcept;
+
+#endif // BATTLE_TILEMAP_HPP
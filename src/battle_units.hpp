@@ -0,0 +1,202 @@
+#ifndef BATTLE_UNITS_HPP
+#define BATTLE_UNITS_HPP
+
+#include "data.hpp"
+#include "gba.hpp"
+#include "map_data.hpp"
+#include "pathfinding.hpp"
+#include "static_vector.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+
+// Refers to a unit in battle_units; stays valid until that unit is removed
+struct unit_handle {
+   std::uint8_t slot;
+
+   friend constexpr bool operator==(const unit_handle&, const unit_handle&) noexcept = default;
+};
+
+enum struct unit_flag : std::uint8_t {
+   moved = 1 << 0,
+   acted = 1 << 1,
+   boss = 1 << 2,
+};
+
+// The units on a battle map, stored as a structure of arrays
+// The battle loop mostly scans positions, HP and flags, so each of those is a small array of its own and the
+// ~300 byte character records are only touched for stat calculations
+// Enemies use slots [0, max_enemies) and player units the rest, so a team is a range of bits in the live mask
+// (A unit's slot also picks its sprite tiles)
+class battle_units {
+public:
+   static constexpr int max_units = max_enemies + max_player_units_on_map;
+   static_assert(max_units <= 32, "The live mask is a single word");
+
+   // The live units of a mask in slot order
+   // Iterating goes over a copy of the mask, so removing units while iterating is fine
+   class range {
+   public:
+      class iterator {
+      public:
+         constexpr explicit iterator(std::uint32_t remaining) noexcept : remaining{remaining} {}
+
+         unit_handle operator*() const noexcept
+         {
+            return {static_cast<std::uint8_t>(std::countr_zero(remaining))};
+         }
+
+         iterator& operator++() noexcept
+         {
+            // Clears the lowest set bit
+            remaining &= remaining - 1;
+            return *this;
+         }
+
+         friend constexpr bool operator==(const iterator&, const iterator&) noexcept = default;
+
+      private:
+         std::uint32_t remaining;
+      };
+
+      constexpr explicit range(std::uint32_t mask) noexcept : mask{mask} {}
+
+      iterator begin() const noexcept { return iterator{mask}; }
+      iterator end() const noexcept { return iterator{0}; }
+      bool empty() const noexcept { return mask == 0; }
+      int size() const noexcept { return std::popcount(mask); }
+      unit_handle front() const noexcept
+      {
+         GBA_ASSERT(!empty());
+         return *begin();
+      }
+
+   private:
+      std::uint32_t mask;
+   };
+
+   range all() const noexcept { return range{live}; }
+   range enemies() const noexcept { return range{live & enemy_mask}; }
+   range players() const noexcept { return range{live & player_mask}; }
+
+   // index is the enemy's index in the map's list, which is used as its slot
+   unit_handle add_enemy(int index, character& stats, pos at, bool is_boss) noexcept
+   {
+      GBA_ASSERT(index >= 0 && index < max_enemies);
+      const auto unit = unit_handle{static_cast<std::uint8_t>(index)};
+      GBA_ASSERT(!is_live(unit));
+      add(unit, stats, at);
+      set(unit, unit_flag::boss, is_boss);
+      return unit;
+   }
+
+   // Takes the first free player slot; there must be one
+   unit_handle add_player(character& stats, pos at) noexcept
+   {
+      const auto free = ~live & player_mask;
+      GBA_ASSERT(free != 0);
+      const auto unit = unit_handle{static_cast<std::uint8_t>(std::countr_zero(free))};
+      add(unit, stats, at);
+      return unit;
+   }
+
+   void remove(unit_handle unit) noexcept
+   {
+      GBA_ASSERT(is_live(unit));
+      live &= ~bit(unit);
+   }
+
+   std::optional<unit_handle> find_at(range units, pos at) const noexcept
+   {
+      for (const auto unit : units) {
+         if (positions[unit.slot] == at) {
+            return unit;
+         }
+      }
+      return std::nullopt;
+   }
+
+   static_vector<pos, max_units> positions_of(range units) const noexcept
+   {
+      static_vector<pos, max_units> to_ret;
+      for (const auto unit : units) {
+         to_ret.push_back(positions[unit.slot]);
+      }
+      return to_ret;
+   }
+
+   bool is_enemy(unit_handle unit) const noexcept { return unit.slot < max_enemies; }
+
+   pos& position(unit_handle unit) noexcept { return positions[unit.slot]; }
+   pos position(unit_handle unit) const noexcept { return positions[unit.slot]; }
+   // Where the unit started the turn
+   pos& start(unit_handle unit) noexcept { return starts[unit.slot]; }
+   pos start(unit_handle unit) const noexcept { return starts[unit.slot]; }
+
+   bool has(unit_handle unit, unit_flag flag) const noexcept
+   {
+      return (flags[unit.slot] & static_cast<std::uint8_t>(flag)) != 0;
+   }
+
+   void set(unit_handle unit, unit_flag flag, bool value = true) noexcept
+   {
+      if (value) {
+         flags[unit.slot] |= static_cast<std::uint8_t>(flag);
+      }
+      else {
+         flags[unit.slot] &= ~static_cast<std::uint8_t>(flag);
+      }
+   }
+
+   std::uint8_t class_of(unit_handle unit) const noexcept { return classes[unit.slot]; }
+   // Scaled like character::hp
+   std::int32_t hp(unit_handle unit) const noexcept { return hps[unit.slot]; }
+   std::int32_t max_hp(unit_handle unit) const noexcept { return max_hps[unit.slot]; }
+
+   character& stats(unit_handle unit) noexcept { return *stats_[unit.slot]; }
+   const character& stats(unit_handle unit) const noexcept { return *stats_[unit.slot]; }
+
+   void take_damage(unit_handle unit, std::int32_t damage) noexcept
+   {
+      stats(unit).take_damage(damage);
+      refresh_hp(unit);
+   }
+
+   // HP is copied out of the character, so this has to be called whenever stats(unit) changes it
+   void refresh_hp(unit_handle unit) noexcept
+   {
+      hps[unit.slot] = stats_[unit.slot]->hp;
+      max_hps[unit.slot] = stats_[unit.slot]->max_hp;
+   }
+
+private:
+   static constexpr std::uint32_t enemy_mask = (1U << max_enemies) - 1;
+   static constexpr std::uint32_t player_mask = ((1U << max_units) - 1) & ~enemy_mask;
+
+   static constexpr std::uint32_t bit(unit_handle unit) noexcept { return 1U << unit.slot; }
+   bool is_live(unit_handle unit) const noexcept { return (live & bit(unit)) != 0; }
+
+   void add(unit_handle unit, character& stats, pos at) noexcept
+   {
+      live |= bit(unit);
+      positions[unit.slot] = at;
+      starts[unit.slot] = at;
+      flags[unit.slot] = 0;
+      classes[unit.slot] = stats.class_;
+      stats_[unit.slot] = &stats;
+      refresh_hp(unit);
+   }
+
+   std::uint32_t live = 0;
+   std::array<pos, max_units> positions;
+   std::array<pos, max_units> starts;
+   std::array<std::uint8_t, max_units> flags;
+   std::array<std::uint8_t, max_units> classes;
+   std::array<std::int32_t, max_units> hps;
+   std::array<std::int32_t, max_units> max_hps;
+   std::array<character*, max_units> stats_;
+};
+
+#endif // BATTLE_UNITS_HPP
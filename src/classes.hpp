@@ -3,10 +3,9 @@
 
 #include <array>
 
+#include "assets.hpp"
 #include "data.hpp"
 
-#include "generated/obj_pal1.hpp"
-
 // TODO: There's probably a better way of doing this?
 enum class_ids : std::uint8_t {
    // dummy class used for placing the cursor
@@ -22,15 +21,15 @@ enum class_ids : std::uint8_t {
 struct class_info {
    std::uint8_t palette;
    const char* name;
-   const std::uint32_t (&sprite)[64];
+   asset_id sprite;
    base_stats stats;
 };
 
 inline constexpr class_info class_data[]{
-   {1, "", obj_pal1::snake, {}},
+   {1, "", asset_id::obj_pal1_snake, {}},
    {1,
     "Snake",
-    obj_pal1::snake,
+    asset_id::obj_pal1_snake,
     {.hp = 10,
      .mp = 5,
      .attack = 10,
@@ -43,7 +42,7 @@ inline constexpr class_info class_data[]{
      .jump = 5}},
    {1,
     "Snake minion",
-    obj_pal1::snake_minion,
+    asset_id::obj_pal1_snake_minion,
     {.hp = 7,
      .mp = 3,
      .attack = 7,
@@ -56,7 +55,7 @@ inline constexpr class_info class_data[]{
      .jump = 3}},
    {1,
     "Evil snake",
-    obj_pal1::evil_snake,
+    asset_id::obj_pal1_evil_snake,
     {.hp = 7,
      .mp = 3,
      .attack = 8,
@@ -69,7 +68,7 @@ inline constexpr class_info class_data[]{
      .jump = 3}},
    {1,
     "Super Snake",
-    obj_pal1::snake,
+    asset_id::obj_pal1_snake,
     {.hp = 40,
      .mp = 40,
      .attack = 40,
@@ -82,7 +81,7 @@ inline constexpr class_info class_data[]{
      .jump = 99}},
    {1,
     "Snail",
-    obj_pal1::snail,
+    asset_id::obj_pal1_snail,
     {.hp = 5,
      .mp = 2,
      .attack = 6,
@@ -95,7 +94,7 @@ inline constexpr class_info class_data[]{
      .jump = 2}},
    {1,
     "Face",
-    obj_pal1::face,
+    asset_id::obj_pal1_face,
     {.hp = 3,
      .mp = 10,
      .attack = 12,
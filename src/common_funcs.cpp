@@ -1,10 +1,15 @@
 #include "common_funcs.hpp"
 
-#include "generated/stats_screen.hpp"
-
+#include "assets.hpp"
 #include "classes.hpp"
 #include "constants.hpp"
+#include "debug_layer.hpp"
+#include "frame_monitor.hpp"
 #include "gba.hpp"
+#include "gba_log.hpp"
+#include "perf_run.hpp"
+#include "profiler.hpp"
+#include "stack_monitor.hpp"
 
 #include <iterator>
 #include <limits>
@@ -12,11 +17,18 @@
 const gba::keypad_status& wait_vblank_and_update(file_save_data& save_data, bool allow_soft_reset) noexcept
 {
    static gba::keypad_status keypad;
+   profiler::end_frame();
+   frame_monitor::logic_finished();
    while (gba::in_vblank()) {}
    while (!gba::in_vblank()) {}
 
    save_data.frame_count += 1;
-   keypad.update();
+   keypad.update(perf_run::read_keys());
+   profiler::begin_frame(keypad);
+   frame_monitor::frame_started(keypad);
+   stack_monitor::frame_started(keypad);
+   debug_layer::present();
+   gba::log::flush();
 
    if (allow_soft_reset && keypad.soft_reset_buttons_held()) {
       gba::soft_reset();
@@ -32,12 +44,6 @@ void disable_all_sprites() noexcept
    }
 }
 
-// Not in gba.hpp because it only works for certain setups
-volatile std::uint16_t* bg_screen_loc_at(gba::bg_opt::screen_base_block loc, int x, int y) noexcept
-{
-   return gba::bg_screen_loc(loc) + x + y * 32;
-}
-
 void write_at_n(
    gba::bg_opt::screen_base_block loc, const char* to_write, const int n, const int x, const int y) noexcept
 {
@@ -142,7 +148,7 @@ int menu(
    int default_choice,
    bool allow_cancel,
    bool draw_the_menu,
-   std::function<void(int, const gba::keypad_status&)> on_refresh) noexcept
+   function_ref<void(int, const gba::keypad_status&)> on_refresh) noexcept
 {
    if (draw_the_menu) {
       draw_menu(options, x, y);
@@ -182,7 +188,7 @@ int menu(
          return -1;
       }
 
-      if (on_refresh != nullptr) {
+      if (on_refresh) {
          on_refresh(choice, keypad);
       }
    }
@@ -233,7 +239,7 @@ int display_stats(file_save_data& save_data, std::span<character> char_list, int
       fmt::format_to_n(buffer, std::size(buffer) - 1, "{: >3}", stat);
       write_bg0(buffer, x, y);
    };
-   const auto disp_hp_mp = [&](std::uint64_t stat, std::uint64_t max_stat, int x, int y) {
+   const auto disp_hp_mp = [&](auto stat, auto max_stat, int x, int y) {
       char buffer[38];
       std::fill(std::begin(buffer), std::end(buffer), '\0');
       // If we have enough digits in the max stat split onto two lines if if'd be too large with full stat
@@ -253,6 +259,7 @@ int display_stats(file_save_data& save_data, std::span<character> char_list, int
    const auto display_char_stats = [&](const character& char_) {
       const auto start_fill = gba::bg_screen_loc(gba::bg_opt::screen_base_block::b62);
       gba::dma3_fill(start_fill, start_fill + 32 * 32, ' ');
+      const auto stats_screen = asset_handle{asset_id::stats_screen}.data<std::uint16_t>();
       gba::copy_tilemap(stats_screen, gba::bg_opt::screen_base_block::b62);
       write_bg0(char_.name.data(), 1, 1);
       write_bg0(class_data[char_.class_].name, 1, 3);
@@ -266,8 +273,16 @@ int display_stats(file_save_data& save_data, std::span<character> char_list, int
       disp_core_stat(char_.remaining_exp(), 16, 4);
       disp_mv_jmp(char_.bases.move, 26, 8);
       disp_mv_jmp(char_.bases.jump, 26, 10);
-      disp_hp_mp(char_.hp, char_.max_hp, 12, 14);
-      disp_hp_mp(char_.mp, char_.max_mp, 12, 17);
+      // Only need 64-bit values to show HP/MP that's been scaled down
+      if (char_.hp_mp_shift == 0) {
+         disp_hp_mp(char_.hp, char_.max_hp, 12, 14);
+         disp_hp_mp(char_.mp, char_.max_mp, 12, 17);
+      }
+      else {
+         const auto unscale = [&](std::int32_t value) { return static_cast<std::int64_t>(value) << char_.hp_mp_shift; };
+         disp_hp_mp(unscale(char_.hp), unscale(char_.max_hp), 12, 14);
+         disp_hp_mp(unscale(char_.mp), unscale(char_.max_mp), 12, 17);
+      }
 
       for (int i = 0; i != static_cast<int>(char_.equips.size()); ++i) {
          const auto& equip = char_.equips[i];
@@ -291,10 +306,7 @@ int display_stats(file_save_data& save_data, std::span<character> char_list, int
          char_obj.set_x(27 * 8);
          char_obj.set_y(1 * 8);
 
-         gba::dma3_copy(
-            std::begin(class_data[char_.class_].sprite),
-            std::end(class_data[char_.class_].sprite),
-            gba::base_obj_tile_addr(0));
+         load_asset(class_data[char_.class_].sprite, gba::base_obj_tile_addr(0));
       }
    };
 
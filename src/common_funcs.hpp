@@ -1,16 +1,20 @@
 #ifndef COMMON_FUNCS_HPP
 #define COMMON_FUNCS_HPP
 
+#include "function_ref.hpp"
 #include "gba.hpp"
 #include "save_data.hpp"
 
-#include <functional>
-
 const gba::keypad_status& wait_vblank_and_update(file_save_data& save_data, bool allow_soft_reset = true) noexcept;
 
 void disable_all_sprites() noexcept;
 
-volatile std::uint16_t* bg_screen_loc_at(gba::bg_opt::screen_base_block loc, int x, int y) noexcept;
+// Not in gba.hpp because it only works for certain setups
+// Inline since it's used per tile by the IWRAM layer updates
+inline volatile std::uint16_t* bg_screen_loc_at(gba::bg_opt::screen_base_block loc, int x, int y) noexcept
+{
+   return gba::bg_screen_loc(loc) + x + y * 32;
+}
 
 void write_at_n(
    gba::bg_opt::screen_base_block loc, const char* to_write, const int n, const int x, const int y) noexcept;
@@ -29,7 +33,7 @@ int menu(
    int default_choice,
    bool allow_cancel,
    bool draw_the_menu = true,
-   std::function<void(int, const gba::keypad_status&)> on_refresh = nullptr) noexcept;
+   function_ref<void(int, const gba::keypad_status&)> on_refresh = nullptr) noexcept;
 
 int display_stats(file_save_data& save_data, std::span<character> char_list, int index, bool allow_equipping) noexcept;
 
@@ -1,10 +1,7 @@
 #ifndef CONSTANTS_HPP
 #define CONSTANTS_HPP
 
-#include "generated/font.hpp"
-#include "generated/test_tileset.hpp"
-
-#include <iterator>
+#include "assets.hpp"
 
 // This isn't an enum struct because we want them to be chars
 namespace font_chars {
@@ -28,8 +25,9 @@ inline constexpr char box_right_vertical = 0x14;
 // TODO: There's probably a better/more flexible way to do this than hard coding stuff like this
 namespace tile_locs {
 
-inline constexpr auto start_tileset = std::size(font) / 8;
-inline constexpr auto start_move_indic = start_tileset + std::size(test_tileset) / 8;
+// Each 4bpp tile is 32 bytes
+inline constexpr auto start_tileset = asset_size(asset_id::font) / 32;
+inline constexpr auto start_move_indic = start_tileset + asset_size(asset_id::test_tileset) / 32;
 
 } // namespace tile_locs
 
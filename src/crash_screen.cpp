@@ -0,0 +1,186 @@
+#include "crash_screen.hpp"
+
+#include "assets.hpp"
+#include "common_funcs.hpp"
+#include "debug_layer.hpp"
+#include "frame_monitor.hpp"
+#include "gba.hpp"
+#include "gba_log.hpp"
+#include "overlay.hpp"
+#include "save_data.hpp"
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+constexpr int num_registers = 17;
+constexpr int num_stack_words = 18;
+
+constexpr std::array<const char*, num_registers> register_names{
+   "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc", "cpsr"};
+constexpr int sp_index = 13;
+
+// The user stack is at the top of IWRAM
+constexpr std::uint32_t stack_start = 0x300'0000;
+constexpr std::uint32_t stack_end = 0x300'8000;
+
+// SRAM copy of the last crash:
+//    char magic[4]        'P', 'K', 'C', '1'
+//    u16 line
+//    u8 scene             frame_scene
+//    u8 overlay           overlay_id (0xFF for none)
+//    u32 registers[17]    r0 to r15 then CPSR
+//    u32 num_stack_words  how many of the stack words were inside the stack
+//    u32 stack[18]        from sp up
+//    char file[32]        NUL terminated, cut short if need be
+//    char expression[64]  likewise
+// It goes after the debug log's SRAM ring (see gba_log.cpp)
+constexpr int sram_offset = 0x7E18;
+
+struct crash_dump {
+   std::array<char, 4> magic;
+   std::uint16_t line;
+   frame_scene scene;
+   overlay_id overlay;
+   std::array<std::uint32_t, num_registers> registers;
+   std::uint32_t stack_words;
+   std::array<std::uint32_t, num_stack_words> stack;
+   std::array<char, 32> file;
+   std::array<char, 64> expression;
+};
+static_assert(sram_offset >= save_data_end);
+static_assert(sram_offset + sizeof(crash_dump) <= 0x8000);
+
+// An assert failing while the screen is drawn comes back to the handler
+bool crashing = false;
+
+template<std::size_t Size>
+void copy_string(std::array<char, Size>& to, const char* from) noexcept
+{
+   const auto length = std::min(std::strlen(from), Size - 1);
+   std::copy_n(from, length, to.begin());
+   to[length] = '\0';
+}
+
+crash_dump make_dump(const char* file, int line, const char* expression, const std::uint32_t* registers) noexcept
+{
+   crash_dump dump{};
+   dump.magic = {'P', 'K', 'C', '1'};
+   dump.line = static_cast<std::uint16_t>(line);
+   dump.scene = frame_monitor::current_scene();
+   dump.overlay = loaded_overlay();
+   std::copy_n(registers, num_registers, dump.registers.begin());
+   const auto sp = registers[sp_index];
+   if (sp >= stack_start && sp < stack_end && sp % 4 == 0) {
+      dump.stack_words = std::min<std::uint32_t>((stack_end - sp) / 4, num_stack_words);
+      const auto stack = reinterpret_cast<const std::uint32_t*>(sp);
+      std::copy_n(stack, dump.stack_words, dump.stack.begin());
+   }
+   copy_string(dump.file, file);
+   copy_string(dump.expression, expression);
+   return dump;
+}
+
+template<typename... Args>
+void draw_line(int y, fmt::format_string<Args...> format, Args&&... args) noexcept
+{
+   char buffer[31];
+   const auto end = fmt::format_to_n(buffer, std::size(buffer) - 1, format, std::forward<Args>(args)...);
+   *end.out = '\0';
+   write_at(debug_layer::screen_block, buffer, 0, y);
+}
+
+void draw(const crash_dump& dump) noexcept
+{
+   gba::lcd.set_options(gba::lcd_options{}.set(gba::lcd_opt::forced_blank::on));
+   load_asset(asset_id::font, gba::bg_char_loc(gba::bg_opt::char_base_block::b0));
+   load_asset(asset_id::font_pal, gba::bg_palette_addr(0));
+   const auto screen = gba::bg_screen_loc(debug_layer::screen_block);
+   gba::dma3_fill(screen, screen + 32 * 32, ' ');
+
+   draw_line(0, "Assertion failed");
+   draw_line(1, "{}:{}", dump.file.data(), dump.line);
+   // The condition gets two rows
+   const auto expression_length = static_cast<int>(std::strlen(dump.expression.data()));
+   write_at_n(debug_layer::screen_block, dump.expression.data(), 30, 0, 2);
+   if (expression_length > 30) {
+      write_at_n(debug_layer::screen_block, dump.expression.data() + 30, 30, 0, 3);
+   }
+   if (dump.overlay == overlay_id::none) {
+      draw_line(4, "scene {} overlay none", frame_monitor::scene_name(dump.scene));
+   }
+   else {
+      draw_line(4, "scene {} overlay {}", frame_monitor::scene_name(dump.scene), static_cast<int>(dump.overlay));
+   }
+   for (int i = 0; i < 8; ++i) {
+      draw_line(5 + i, "{: <4}{:08x}  {: <4}{:08x}", register_names[i], dump.registers[i], register_names[i + 8],
+         dump.registers[i + 8]);
+   }
+   draw_line(13, "{: <4}{:08x}  stack", register_names[16], dump.registers[16]);
+   for (std::uint32_t i = 0; i < dump.stack_words; i += 3) {
+      const auto& stack = dump.stack;
+      const auto words = dump.stack_words - i;
+      const int y = 14 + static_cast<int>(i / 3);
+      if (words >= 3) {
+         draw_line(y, "{:08x} {:08x} {:08x}", stack[i], stack[i + 1], stack[i + 2]);
+      }
+      else if (words == 2) {
+         draw_line(y, "{:08x} {:08x}", stack[i], stack[i + 1]);
+      }
+      else {
+         draw_line(y, "{:08x}", stack[i]);
+      }
+   }
+
+   {
+      using namespace gba::bg_opt;
+      gba::bg0.set_options(gba::bg_options{}
+                              .set(priority::p0)
+                              .set(char_base_block::b0)
+                              .set(mosaic::disable)
+                              .set(colors_palettes::c16_p16)
+                              .set(debug_layer::screen_block)
+                              .set(display_area_overflow::transparent)
+                              .set(screen_size::text_256x256));
+      gba::bg0.set_scroll(0, 0);
+   }
+   {
+      using namespace gba::lcd_opt;
+      gba::lcd.set_options(gba::lcd_options{}
+                              .set(bg_mode::mode_0)
+                              .set(forced_blank::off)
+                              .set(display_bg0::on)
+                              .set(display_window_0::off)
+                              .set(display_window_1::off)
+                              .set(display_window_obj::off)
+                              .set(obj_char_mapping::one_dimensional));
+   }
+}
+
+[[noreturn]] void show(const char* file, int line, const char* expression, const std::uint32_t* registers) noexcept
+{
+   if (!crashing) {
+      crashing = true;
+      const auto dump = make_dump(file, line, expression, registers);
+      // Saved first in case drawing fails too
+      sram_write(dump, gba::sram_addr() + sram_offset);
+      gba::log::print(gba::log::level::fatal, "{}:{}: assertion failed: {}", file, line, expression);
+      gba::log::flush();
+      draw(dump);
+   }
+   while (true) {}
+}
+
+} // anonymous namespace
+
+namespace crash_screen {
+
+void install() noexcept { gba::set_assert_handler(show); }
+
+} // namespace crash_screen
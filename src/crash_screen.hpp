@@ -0,0 +1,14 @@
+#ifndef CRASH_SCREEN_HPP
+#define CRASH_SCREEN_HPP
+
+// What a failed GBA_ASSERT shows on the GBA: the file, line and condition, the registers, the top of the stack and
+// the scene, which are also logged as fatal and kept in SRAM after the debug log (scripts/decode_crash_sram.py reads
+// them) until the next crash
+namespace crash_screen {
+
+// Makes failed asserts show the crash screen rather than hang; call once at boot
+void install() noexcept;
+
+} // namespace crash_screen
+
+#endif // CRASH_SCREEN_HPP
@@ -0,0 +1,31 @@
+#include "crc16.hpp"
+
+#include <array>
+
+namespace {
+
+constexpr std::array<std::uint16_t, 256> make_crc16_table() noexcept
+{
+   std::array<std::uint16_t, 256> to_ret;
+   for (int i = 0; i < 256; ++i) {
+      std::uint16_t crc = i << 8;
+      for (int bit = 0; bit < 8; ++bit) {
+         crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+      }
+      to_ret[i] = crc;
+   }
+   return to_ret;
+}
+
+// Not const so it's placed in IWRAM rather than ROM
+GBA_IWRAM_DATA constinit std::array<std::uint16_t, 256> crc16_table = make_crc16_table();
+
+} // anonymous namespace
+
+GBA_IWRAM_OVERLAY_CODE(MENU_OVERLAY) std::uint16_t crc16(std::span<const std::uint8_t> data, std::uint16_t crc) noexcept
+{
+   for (const auto byte : data) {
+      crc = (crc << 8) ^ crc16_table[(crc >> 8) ^ byte];
+   }
+   return crc;
+}
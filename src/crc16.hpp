@@ -0,0 +1,16 @@
+#ifndef CRC16_HPP
+#define CRC16_HPP
+
+#include "gba.hpp"
+#include "overlay.hpp"
+
+#include <cstdint>
+#include <span>
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+// Pass the previous result in as crc to continue a checksum over multiple pieces
+// This runs from the menu overlay as ARM code (battles don't save)
+GBA_IWRAM_OVERLAY_CODE(MENU_OVERLAY) std::uint16_t crc16(
+   std::span<const std::uint8_t> data, std::uint16_t crc = 0xFFFF) noexcept;
+
+#endif // CRC16_HPP
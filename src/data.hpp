@@ -1,20 +1,37 @@
 #ifndef DATA_HPP
 #define DATA_HPP
 
+#include "prng.hpp"
+#include "stat_math.hpp"
+
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstdint>
-#include <random>
+#include <utility>
 
 constexpr int max_move = 7;
 
+// HP/MP are scaled down so the max values stay below this, which leaves room for the health bar's 16 * hp
+inline constexpr std::int32_t max_scaled_hp_mp = 1 << 26;
+
+// The smallest shift that brings max_value under max_scaled_hp_mp
+inline int hp_mp_shift_for(double max_value) noexcept
+{
+   int shift = 0;
+   while (std::ldexp(max_value, -shift) >= max_scaled_hp_mp) {
+      ++shift;
+   }
+   return shift;
+}
+
 struct item {
    bool exists = false;
    std::uint8_t item_name;
    std::int8_t move;
    std::int8_t jump;
-   std::int64_t hp;
-   std::int64_t mp;
+   std::int32_t hp;
+   std::int32_t mp;
    std::int32_t attack;
    std::int32_t defense;
    std::int32_t m_attack;
@@ -43,10 +60,14 @@ struct character {
    base_stats bases;
    std::array<char, 16> name;
    std::int32_t level;
-   std::int64_t hp;
-   std::int64_t max_hp;
-   std::int64_t mp;
-   std::int64_t max_mp;
+   // HP/MP are stored divided by 2^hp_mp_shift so they fit in 32 bits at high enemy strengths
+   // calc_stats picks the shift; it's 0 unless the max values are enormous
+   // HP/MP start at 0 so calc_stats can rescale them on a new character
+   std::int32_t hp = 0;
+   std::int32_t max_hp;
+   std::int32_t mp = 0;
+   std::int32_t max_mp;
+   std::uint8_t hp_mp_shift = 0;
    std::int32_t attack;
    std::int32_t defense;
    std::int32_t m_attack;
@@ -57,9 +78,9 @@ struct character {
    std::int32_t exp = 0;
 
    // Calc stats DOES NOT set HP/MP; just the max values
-   void calc_stats(bool randomize) noexcept
+   // If rng isn't null each stat is randomly adjusted by up to 5%
+   void calc_stats(prng* rng) noexcept
    {
-      static std::minstd_rand0 prng;
       const std::array<std::pair<std::int32_t&, std::uint8_t&>, 6> stats_and_bases{
          {{attack, bases.attack},
           {defense, bases.defense},
@@ -68,15 +89,36 @@ struct character {
           {speed, bases.speed},
           {hit, bases.hit}}};
       for (auto& [stat, base] : stats_and_bases) {
-         const int random_factor = randomize ? std::uniform_int_distribution<int>{950, 1050}(prng) : 1000;
-         stat = base * std::pow(level + 3, 1.05) * random_factor / 1000;
+         const int random_factor = rng != nullptr ? rng->between(950, 1050) : 1000;
+         stat = sat_from_double(base * std::pow(level + 3, 1.05) * random_factor / 1000);
       }
-      const std::array<std::pair<std::int64_t&, std::uint8_t&>, 2> stats_and_bases2{
-         {{max_hp, bases.hp}, {max_mp, bases.mp}}};
-      for (auto& [stat, base] : stats_and_bases2) {
-         const int random_factor = randomize ? std::uniform_int_distribution<int>{950, 1050}(prng) : 1000;
-         stat = base * 2 * std::pow(level + 3, 1.25) * random_factor / 1000;
+      std::array<double, 2> new_max_hp_mp;
+      const std::array<std::uint8_t, 2> hp_mp_bases{bases.hp, bases.mp};
+      for (int i = 0; i < 2; ++i) {
+         const int random_factor = rng != nullptr ? rng->between(950, 1050) : 1000;
+         new_max_hp_mp[i] = hp_mp_bases[i] * 2 * std::pow(level + 3, 1.25) * random_factor / 1000;
       }
+      const auto new_shift = hp_mp_shift_for(std::max(new_max_hp_mp[0], new_max_hp_mp[1]));
+      hp = rescale_hp_mp(hp, new_shift);
+      mp = rescale_hp_mp(mp, new_shift);
+      hp_mp_shift = new_shift;
+      max_hp = sat_from_double(std::ldexp(new_max_hp_mp[0], -hp_mp_shift));
+      max_mp = sat_from_double(std::ldexp(new_max_hp_mp[1], -hp_mp_shift));
+   }
+
+   // Converts an HP/MP value from the current shift to new_shift
+   std::int32_t rescale_hp_mp(std::int32_t value, int new_shift) const noexcept
+   {
+      if (new_shift >= hp_mp_shift) {
+         return value >> (new_shift - hp_mp_shift);
+      }
+      return sat_mul(value, 1 << (hp_mp_shift - new_shift));
+   }
+
+   // damage is unscaled; it's rounded up so any damage at all does something
+   void take_damage(std::int32_t damage) noexcept
+   {
+      hp = sat_sub(hp, sat_add(damage, (1 << hp_mp_shift) - 1) >> hp_mp_shift);
    }
 
    void level_up_if_needed() noexcept
@@ -88,7 +130,7 @@ struct character {
       }
       if (start_level != level) {
          // Only character units get experience so can always not randomize
-         calc_stats(false);
+         calc_stats(nullptr);
       }
    }
 
@@ -98,35 +140,21 @@ struct character {
       mp = max_mp;
    }
 
-   std::int32_t needed_exp() const noexcept
-   {
-      return std::min(50 * static_cast<std::int64_t>(level), static_cast<std::int64_t>(999'999'999));
-   }
+   std::int32_t needed_exp() const noexcept { return std::min(sat_mul(50, level), 999'999'999); }
 
-   std::int32_t remaining_exp() const noexcept { return needed_exp() - exp; }
+   std::int32_t remaining_exp() const noexcept { return sat_sub(needed_exp(), exp); }
 };
 
-inline std::int64_t calc_normal_damage(const character& attacker, const character& defender) noexcept
+inline std::int32_t calc_normal_damage(const character& attacker, const character& defender) noexcept
 {
-   const auto base_damage = static_cast<std::int64_t>(attacker.attack) * 5 / 3 - defender.defense;
+   // attack * 5 / 3 split up so the multiply can't overflow
+   const auto attack = attacker.attack;
+   const auto scaled_attack = sat_add(attack, attack / 3 * 2 + attack % 3 * 2 / 3);
+   const auto base_damage = sat_sub(scaled_attack, defender.defense);
    if (base_damage < 0) {
       return 0;
    }
    return base_damage;
 }
 
-struct combatant {
-   std::int8_t x;
-   std::int8_t y;
-   std::int8_t start_x;
-   std::int8_t start_y;
-   std::int8_t index;
-   bool moved = false;
-   bool acted = false;
-   bool is_enemy = false;
-   bool is_boss = false;
-   int tile_no;
-   character* stats;
-};
-
 #endif // DATA_HPP
@@ -0,0 +1,43 @@
+#include "debug_layer.hpp"
+
+namespace {
+
+int num_users = 0;
+// Put back when the last overlay is hidden
+gba::bg_opt::screen_base_block saved_screen_block;
+
+} // anonymous namespace
+
+namespace debug_layer {
+
+void acquire() noexcept
+{
+   if (num_users == 0) {
+      const auto bg0_options = gba::bg0.get_options().or_mask;
+      saved_screen_block = static_cast<gba::bg_opt::screen_base_block>((bg0_options >> 8) & 0b1'1111);
+      const auto screen = gba::bg_screen_loc(screen_block);
+      gba::dma3_fill(screen, screen + 32 * 32, ' ');
+   }
+   num_users += 1;
+}
+
+void release(int first_row, int num_rows) noexcept
+{
+   GBA_ASSERT(num_users > 0);
+   num_users -= 1;
+   const auto screen = gba::bg_screen_loc(screen_block);
+   gba::dma3_fill(screen + first_row * 32, screen + (first_row + num_rows) * 32, ' ');
+   if (num_users == 0) {
+      gba::bg0.set_options(gba::preserve, gba::bg_options{}.set(saved_screen_block));
+   }
+}
+
+void present() noexcept
+{
+   if (num_users > 0) {
+      gba::bg0.set_options(gba::preserve, gba::bg_options{}.set(screen_block));
+      gba::bg0.set_scroll(0, 0);
+   }
+}
+
+} // namespace debug_layer
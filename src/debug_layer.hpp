@@ -0,0 +1,23 @@
+#ifndef DEBUG_LAYER_HPP
+#define DEBUG_LAYER_HPP
+
+#include "gba.hpp"
+
+// BG0 is borrowed by the debug overlays (the profiler and the frame monitor) while any of them is showing
+// The layer is switched to a screen block nothing else uses, with no scroll; each overlay draws on its own rows
+namespace debug_layer {
+
+// Nothing else uses this screen block (the battle uses 56 to 62 and the menus 62)
+inline constexpr auto screen_block = gba::bg_opt::screen_base_block::b54;
+
+// Each overlay acquires the layer when it's shown and releases it when it's hidden, which clears its rows
+void acquire() noexcept;
+void release(int first_row, int num_rows) noexcept;
+
+// Called every frame after the overlays draw; scenes that set BG0's scroll every frame call it again afterwards
+// so the overlays stay put
+void present() noexcept;
+
+} // namespace debug_layer
+
+#endif // DEBUG_LAYER_HPP
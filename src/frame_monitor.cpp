@@ -0,0 +1,120 @@
+#include "frame_monitor.hpp"
+
+#include "common_funcs.hpp"
+#include "debug_layer.hpp"
+#include "gba_log.hpp"
+#include "stack_monitor.hpp"
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+using frame_monitor::lines_per_bucket;
+using frame_monitor::num_buckets;
+using frame_monitor::scene_stats;
+
+constexpr std::array<const char*, frame_monitor::num_scenes> scene_names{
+   "title",
+   "menus",
+   "battle",
+};
+
+// Below the profiler's rows
+constexpr int hud_first_row = 7;
+constexpr int hud_rows = 8;
+
+std::array<scene_stats, frame_monitor::num_scenes> stats{};
+frame_scene scene = frame_scene::menus;
+bool hud_visible = false;
+
+template <typename... Args>
+void draw_line(int y, fmt::format_string<Args...> format, Args&&... args) noexcept
+{
+   char buffer[31];
+   const auto end = fmt::format_to_n(buffer, std::size(buffer) - 1, format, std::forward<Args>(args)...);
+   *end.out = '\0';
+   write_at(debug_layer::screen_block, buffer, 0, hud_first_row + y);
+}
+
+void draw_hud() noexcept
+{
+   draw_line(0, "{: <7}{: >6}{: >8}{: >7}", "scene", "late", "frames", "worst");
+   for (int i = 0; i < frame_monitor::num_scenes; ++i) {
+      const auto& scene_stat = stats[i];
+      draw_line(i + 1, "{: <7}{: >6}{: >8}{: >7}", scene_names[i], scene_stat.late_frames, scene_stat.frames,
+         scene_stat.worst_lines);
+   }
+   const auto& histogram = stats[static_cast<int>(scene)].histogram;
+   draw_line(5, "{: <7}{: <23}", scene_names[static_cast<int>(scene)], "logic lines");
+   draw_line(6, "{: >6}{: >6}{: >6}{: >6}{: >6}", "<57", "<114", "<171", "<228", "late");
+   draw_line(7, "{: >6}{: >6}{: >6}{: >6}{: >6}", histogram[0], histogram[1], histogram[2], histogram[3],
+      histogram[4]);
+}
+
+} // anonymous namespace
+
+namespace frame_monitor {
+
+void start() noexcept
+{
+   gba::enable_vblank_flag();
+   gba::clear_vblank_flag();
+}
+
+void logic_finished() noexcept
+{
+   const bool late = gba::vblank_flag();
+   // Frames start when VBlank does, at line 160
+   auto lines = (gba::vcount() + lines_per_frame - 160) % lines_per_frame;
+   if (late) {
+      lines += lines_per_frame;
+      GBA_LOG(debug, "late frame in {}: {} lines", scene_names[static_cast<int>(scene)], lines);
+   }
+   auto& scene_stat = stats[static_cast<int>(scene)];
+   scene_stat.frames += 1;
+   scene_stat.late_frames += late;
+   scene_stat.worst_lines = std::max(scene_stat.worst_lines, lines);
+   scene_stat.histogram[late ? num_buckets - 1 : lines / lines_per_bucket] += 1;
+}
+
+void frame_started(const gba::keypad_status& keypad) noexcept
+{
+   gba::clear_vblank_flag();
+   if (keypad.select_held() && keypad.r_pressed()) {
+      hud_visible = !hud_visible;
+      if (hud_visible) {
+         stats = {};
+         debug_layer::acquire();
+      }
+      else {
+         debug_layer::release(hud_first_row, hud_rows);
+      }
+   }
+   if (hud_visible) {
+      draw_hud();
+   }
+}
+
+frame_scene current_scene() noexcept { return scene; }
+
+const char* scene_name(frame_scene scene_) noexcept { return scene_names[static_cast<int>(scene_)]; }
+
+const scene_stats& stats_for(frame_scene scene_) noexcept { return stats[static_cast<int>(scene_)]; }
+
+scene_scope::scene_scope(frame_scene scene_) noexcept : previous{scene}
+{
+   stack_monitor::take_mark(scene);
+   scene = scene_;
+}
+
+scene_scope::~scene_scope() noexcept
+{
+   stack_monitor::take_mark(scene);
+   scene = previous;
+}
+
+} // namespace frame_monitor
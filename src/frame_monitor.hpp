@@ -0,0 +1,69 @@
+#ifndef FRAME_MONITOR_HPP
+#define FRAME_MONITOR_HPP
+
+#include "gba.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Frame budget monitor, kept in release builds since it only costs a few register reads a frame
+// A frame's logic time is measured in scanlines from the start of VBlank to when wait_vblank_and_update is called,
+// and the frame is late if another VBlank started before then (so the game dropped to 30fps or worse)
+// Holding SELECT and pressing R toggles a HUD on the debug layer with the counts since it was last shown
+enum struct frame_scene : std::uint8_t {
+   title,
+   menus,
+   battle,
+   count
+};
+
+namespace frame_monitor {
+
+inline constexpr auto num_scenes = static_cast<int>(frame_scene::count);
+inline constexpr int lines_per_frame = 228;
+
+// Quarters of a frame, then late frames
+inline constexpr int num_buckets = 5;
+inline constexpr int lines_per_bucket = lines_per_frame / 4;
+
+struct scene_stats {
+   std::uint32_t frames;
+   std::uint32_t late_frames;
+   // Late frames count as a whole frame plus however far into the next one they got, so frames more than one
+   // frame late aren't told apart
+   int worst_lines;
+   std::array<std::uint32_t, num_buckets> histogram;
+};
+
+// Sets up the VBlank flag used to spot late frames; call once at boot
+void start() noexcept;
+
+// wait_vblank_and_update calls these around waiting
+// frame_started also handles the HUD toggle and draws the HUD (during vblank)
+void logic_finished() noexcept;
+void frame_started(const gba::keypad_status& keypad) noexcept;
+
+frame_scene current_scene() noexcept;
+const char* scene_name(frame_scene scene) noexcept;
+
+// Counted since boot or since the HUD was last shown
+const scene_stats& stats_for(frame_scene scene) noexcept;
+
+// Frames are counted against the scene in scope; anything outside a scene counts as menus
+// Changing scene also takes a stack mark for the scene that's ending (see stack_monitor.hpp)
+class scene_scope {
+public:
+   explicit scene_scope(frame_scene scene) noexcept;
+
+   scene_scope(const scene_scope&) = delete;
+   scene_scope& operator=(const scene_scope&) = delete;
+
+   ~scene_scope() noexcept;
+
+private:
+   frame_scene previous;
+};
+
+} // namespace frame_monitor
+
+#endif // FRAME_MONITOR_HPP
@@ -0,0 +1,40 @@
+#ifndef FUNCTION_REF_HPP
+#define FUNCTION_REF_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// A non-owning reference to something callable, for callbacks that are only called during the call they're passed
+// to; unlike std::function it never allocates, and it's two words passed in registers
+// It doesn't extend the callable's lifetime, so don't keep one past the full expression it was made in
+template<typename Signature>
+class function_ref;
+
+template<typename R, typename... Args>
+class function_ref<R(Args...)> {
+public:
+   constexpr function_ref() noexcept = default;
+   constexpr function_ref(std::nullptr_t) noexcept {}
+
+   template<typename F>
+      requires(!std::is_same_v<std::remove_cvref_t<F>, function_ref> && std::is_invocable_r_v<R, F&, Args...>)
+   constexpr function_ref(F&& f) noexcept
+      : object{const_cast<void*>(static_cast<const void*>(std::addressof(f)))},
+        call{[](void* object_, Args... args) -> R {
+           return (*static_cast<std::remove_reference_t<F>*>(object_))(std::forward<Args>(args)...);
+        }}
+   {
+   }
+
+   R operator()(Args... args) const { return call(object, std::forward<Args>(args)...); }
+
+   constexpr explicit operator bool() const noexcept { return call != nullptr; }
+
+private:
+   void* object = nullptr;
+   R (*call)(void*, Args...) = nullptr;
+};
+
+#endif // FUNCTION_REF_HPP
@@ -1,18 +1,82 @@
 #ifndef GBA_HPP
 #define GBA_HPP
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <span>
 
-#ifdef NDEBUG
-   #define GBA_ASSERT(cond) (void)(cond)
+#ifdef GBA_HOST
+   #include "gba_host.hpp"
+#endif
+
+// Assert levels, picked per build type in CMakeLists.txt: 0 (Release) compiles asserts out, conditions and all,
+// 1 (RelWithDebInfo) checks GBA_ASSERT, and 2 (Debug) also checks GBA_ASSERT_PARANOID, which is for checks on hot
+// paths (tile and sprite helpers) that are too costly to leave in test builds
+// A failed assert aborts on the host and shows the crash screen on the GBA (see crash_screen.hpp)
+#ifndef GBA_ASSERT_LEVEL
+   #ifdef NDEBUG
+      #define GBA_ASSERT_LEVEL 0
+   #else
+      #define GBA_ASSERT_LEVEL 2
+   #endif
+#endif
+
+// Only the file's name, to keep the paths out of the ROM
+#ifdef __FILE_NAME__
+   #define GBA_DETAIL_FILE_NAME __FILE_NAME__
+#else
+   #define GBA_DETAIL_FILE_NAME __FILE__
+#endif
+
+#define GBA_DETAIL_CHECK(cond)                                                     \
+   do {                                                                            \
+      if (!(cond)) [[unlikely]] {                                                  \
+         gba::detail::assert_failed(GBA_DETAIL_FILE_NAME, __LINE__, #cond);        \
+      }                                                                            \
+   } while (0)
+// Unevaluated, so the condition costs nothing but still has to compile
+#define GBA_DETAIL_IGNORE(cond) (void)sizeof(!(cond))
+
+#if GBA_ASSERT_LEVEL >= 1
+   #define GBA_ASSERT(cond) GBA_DETAIL_CHECK(cond)
+#else
+   #define GBA_ASSERT(cond) GBA_DETAIL_IGNORE(cond)
+#endif
+
+#if GBA_ASSERT_LEVEL >= 2
+   #define GBA_ASSERT_PARANOID(cond) GBA_DETAIL_CHECK(cond)
+#else
+   #define GBA_ASSERT_PARANOID(cond) GBA_DETAIL_IGNORE(cond)
+#endif
+
+// Placement of code and data (none of which means anything in the host build)
+#ifdef GBA_HOST
+   #define GBA_IWRAM_CODE
+   #define GBA_IWRAM_OVERLAY_CODE(n)
+   #define GBA_IWRAM_DATA
+   #define GBA_EWRAM_DATA
+   #define GBA_EWRAM_BSS
+   #define GBA_ARM
+   #define GBA_THUMB
 #else
-   // TODO: Improve this; currently just hangs if condition is true
-   #define GBA_ASSERT(cond) \
-      do {                  \
-         while (!(cond)) {} \
-      } while (0)
+// ROM is 16-bit with wait states, so hot code is put in IWRAM (32-bit, no wait states) and compiled as ARM
+// IWRAM is out of branch range of ROM, so IWRAM functions are long_call; use the macro on the declaration too
+#define GBA_IWRAM_CODE [[gnu::section(".iwram"), gnu::long_call, gnu::target("arm")]]
+// Like GBA_IWRAM_CODE but in overlay n (0 to 9), which has to be loaded before calling it (see overlay.hpp)
+#define GBA_IWRAM_OVERLAY_CODE(n) \
+   [[gnu::section(".iwram" GBA_DETAIL_STRINGIFY(n)), gnu::long_call, gnu::target("arm")]]
+#define GBA_DETAIL_STRINGIFY(x) #x
+// Mutable data in IWRAM; const data would stay in ROM anyway
+// (Not plain .iwram, which would conflict with code in the same file)
+#define GBA_IWRAM_DATA [[gnu::section(".iwram.data")]]
+// Initialized data in EWRAM; the initial values take up space in the ROM
+#define GBA_EWRAM_DATA [[gnu::section(".ewram")]]
+// Zero-initialized data in EWRAM; takes up no ROM, but initializers other than zero aren't applied
+#define GBA_EWRAM_BSS [[gnu::section(".sbss")]]
+// The instruction set for a single function; whole files can be switched in CMakeLists.txt instead
+#define GBA_ARM [[gnu::target("arm")]]
+#define GBA_THUMB [[gnu::target("thumb")]]
 #endif
 
 namespace gba {
@@ -33,6 +97,70 @@ inline constexpr std::uintptr_t iwram_end{iwram_start + 0x8000};
 inline constexpr std::uintptr_t game_pack_start{0x800'0000};
 inline constexpr std::uintptr_t game_pack_end{game_pack_start + 0x600'0000};
 
+namespace detail {
+
+// Every memory-mapped address goes through here so the host build can redirect it to plain memory
+template<typename T>
+inline volatile T* mmio(std::uintptr_t addr) noexcept
+{
+#ifdef GBA_HOST
+   return reinterpret_cast<volatile T*>(host::translate(addr));
+#else
+   return reinterpret_cast<volatile T*>(addr);
+#endif
+}
+
+#ifdef GBA_HOST
+
+using host::assert_failed;
+
+#else
+
+using assert_handler_type = void (*)(const char* file, int line, const char* expression,
+   const std::uint32_t* registers) noexcept;
+
+extern "C" {
+// Set with set_assert_handler; a failed assert hangs until there is one
+inline assert_handler_type gba_assert_handler = nullptr;
+}
+
+// Passes the handler r0 to r14 as they were when the assert failed, then r15 (the return address, so just after the
+// call here) and CPSR
+// Naked so nothing is touched before the registers are saved, and ARM for MRS
+[[noreturn, gnu::naked, gnu::noinline, gnu::cold, gnu::target("arm")]] inline void assert_failed(
+   [[maybe_unused]] const char* file, [[maybe_unused]] int line, [[maybe_unused]] const char* expression) noexcept
+{
+   asm volatile(
+      // 17 registers plus a word to keep the stack 8-byte aligned
+      "sub sp, sp, #72\n"
+      "stmia sp, {r0-r12}\n"
+      "add r3, sp, #72\n"
+      "str r3, [sp, #52]\n"
+      "str lr, [sp, #56]\n"
+      "str lr, [sp, #60]\n"
+      "mrs r3, cpsr\n"
+      "str r3, [sp, #64]\n"
+      "mov r3, sp\n"
+      "ldr r12, =gba_assert_handler\n"
+      "ldr r12, [r12]\n"
+      "cmp r12, #0\n"
+      "movne lr, pc\n"
+      "bxne r12\n"
+      "1: b 1b\n"
+      ".ltorg\n");
+}
+
+#endif
+
+} // namespace detail
+
+#ifndef GBA_HOST
+
+// The handler must not return
+inline void set_assert_handler(detail::assert_handler_type handler) noexcept { detail::gba_assert_handler = handler; }
+
+#endif
+
 namespace lcd_opt {
 
 enum class bg_mode {
@@ -156,6 +284,34 @@ enum class enable {
 
 } // namespace dma_opt
 
+namespace timer_opt {
+
+// Clock cycles per tick
+enum class prescaler {
+   f1,
+   f64,
+   f256,
+   f1024
+};
+
+// Ticks when the previous timer overflows rather than on the prescaler
+enum class cascade {
+   off,
+   on
+};
+
+enum class irq {
+   disable,
+   enable
+};
+
+enum class enable {
+   off,
+   on
+};
+
+} // namespace timer_opt
+
 namespace bg_opt {
 
 enum class priority {
@@ -480,6 +636,19 @@ struct dma_options : detail::opt_base<0b1111'0111'1111'1111> {
 
 #undef MAKE_SET_NAMESPACE
 
+#define MAKE_SET_NAMESPACE timer_opt
+
+struct timer_options : detail::opt_base<0xFFFF> {
+   using self = timer_options;
+
+   MAKE_SET2(prescaler, 0)
+   MAKE_SET(cascade, 2)
+   MAKE_SET(irq, 6)
+   MAKE_SET(enable, 7)
+};
+
+#undef MAKE_SET_NAMESPACE
+
 #define MAKE_SET_NAMESPACE bg_opt
 
 // Left out bits are "must be 0"
@@ -572,7 +741,7 @@ struct dma {
 
    void set_source(volatile const void* ptr) const noexcept
    {
-      const auto value = reinterpret_cast<std::uint32_t>(ptr);
+      const auto value = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(ptr));
       if (num == 0) {
          GBA_ASSERT(is_internal_memory(value));
       }
@@ -583,7 +752,7 @@ struct dma {
 
    void set_destination(volatile void* ptr) const noexcept
    {
-      const auto value = reinterpret_cast<std::uint32_t>(ptr);
+      const auto value = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(ptr));
       if (num != 3) {
          GBA_ASSERT(is_internal_memory(value));
       }
@@ -604,10 +773,10 @@ struct dma {
    }
 
 private:
-   volatile std::uint32_t* source_addr() const noexcept { return reinterpret_cast<std::uint32_t*>(source_addr_raw); }
-   volatile std::uint32_t* dest_addr() const noexcept { return reinterpret_cast<std::uint32_t*>(dest_addr_raw); }
-   volatile std::uint16_t* word_count() const noexcept { return reinterpret_cast<std::uint16_t*>(word_count_raw); }
-   volatile std::uint16_t* control() const noexcept { return reinterpret_cast<std::uint16_t*>(control_raw); }
+   volatile std::uint32_t* source_addr() const noexcept { return detail::mmio<std::uint32_t>(source_addr_raw); }
+   volatile std::uint32_t* dest_addr() const noexcept { return detail::mmio<std::uint32_t>(dest_addr_raw); }
+   volatile std::uint16_t* word_count() const noexcept { return detail::mmio<std::uint16_t>(word_count_raw); }
+   volatile std::uint16_t* control() const noexcept { return detail::mmio<std::uint16_t>(control_raw); }
 
    int num;
    std::uintptr_t source_addr_raw;
@@ -621,18 +790,81 @@ constexpr dma dma1{1, 0x40000BC, detail::dma_builder{}};
 constexpr dma dma2{2, 0x40000C8, detail::dma_builder{}};
 constexpr dma dma3{3, 0x40000D4, detail::dma_builder{}};
 
+namespace detail {
+struct timer_builder {};
+} // namespace detail
+
+struct timer {
+   constexpr timer(std::uintptr_t base_addr, detail::timer_builder) noexcept
+      : counter_raw{base_addr}, control_raw{base_addr + 2}
+   {}
+
+   // The counter is reloaded with this when it overflows or the timer is enabled
+   void set_reload(std::uint16_t value) const noexcept { *counter_addr() = value; }
+
+   std::uint16_t counter() const noexcept { return *counter_addr(); }
+
+   void set_options(timer_options opt) const noexcept { *control() = opt.or_mask; }
+
+private:
+   // Writes go to the reload value and reads come from the counter
+   volatile std::uint16_t* counter_addr() const noexcept { return detail::mmio<std::uint16_t>(counter_raw); }
+   volatile std::uint16_t* control() const noexcept { return detail::mmio<std::uint16_t>(control_raw); }
+
+   std::uintptr_t counter_raw;
+   std::uintptr_t control_raw;
+};
+
+constexpr timer timer0{0x400'0100, detail::timer_builder{}};
+constexpr timer timer1{0x400'0104, detail::timer_builder{}};
+constexpr timer timer2{0x400'0108, detail::timer_builder{}};
+constexpr timer timer3{0x400'010C, detail::timer_builder{}};
+
+// A 32-bit count of CPU cycles made by cascading timer 3 off of timer 2
+// It wraps after about 4 minutes, so only differences between counts are meaningful
+inline void start_cycle_counter() noexcept
+{
+   using namespace gba::timer_opt;
+   timer2.set_options(timer_options{}.set(enable::off));
+   timer3.set_options(timer_options{}.set(enable::off));
+   timer2.set_reload(0);
+   timer3.set_reload(0);
+   // Timer 3 is started first so it doesn't miss timer 2's first overflow
+   timer3.set_options(timer_options{}.set(cascade::on).set(enable::on));
+   timer2.set_options(timer_options{}.set(prescaler::f1).set(enable::on));
+}
+
+inline std::uint32_t cycle_count() noexcept
+{
+#ifdef GBA_HOST
+   return host::cycle_count();
+#else
+   // Re-read if timer 2 overflowed between reading the two halves
+   std::uint16_t high;
+   std::uint16_t low;
+   do {
+      high = timer3.counter();
+      low = timer2.counter();
+   } while (high != timer3.counter());
+   return (static_cast<std::uint32_t>(high) << 16) | low;
+#endif
+}
+
+// CPU cycles per frame (228 lines of 1232 cycles)
+inline constexpr std::uint32_t cycles_per_frame = 280'896;
+
 namespace detail {
 
 struct lcd {
    void set_options(detail::preserve, lcd_options opt) const noexcept
    {
-      volatile auto* control = reinterpret_cast<std::uint16_t*>(0x400'0000);
+      volatile auto* control = mmio<std::uint16_t>(0x400'0000);
       opt.apply_to(control);
    }
 
    void set_options(lcd_options opt) const noexcept
    {
-      volatile auto* control = reinterpret_cast<std::uint16_t*>(0x400'0000);
+      volatile auto* control = mmio<std::uint16_t>(0x400'0000);
       *control = opt.or_mask;
    }
 };
@@ -655,6 +887,14 @@ public:
 
    void set_options(bg_options opt) const noexcept { *control_addr() = opt.or_mask; }
 
+   // For putting the options back after borrowing the layer (the scroll registers can't be read)
+   bg_options get_options() const noexcept
+   {
+      bg_options opt;
+      opt.or_mask = *control_addr();
+      return opt;
+   }
+
    void set_x_scroll(int x) const noexcept { *x_scroll_addr() = x; }
 
    void set_y_scroll(int y) const noexcept { *y_scroll_addr() = y; }
@@ -668,15 +908,15 @@ public:
 private:
    volatile std::uint16_t* control_addr() const noexcept
    {
-      return reinterpret_cast<std::uint16_t*>(0x0400'0008 + num * 2);
+      return detail::mmio<std::uint16_t>(0x0400'0008 + num * 2);
    }
    volatile std::uint16_t* x_scroll_addr() const noexcept
    {
-      return reinterpret_cast<std::uint16_t*>(0x0400'0010 + num * 4);
+      return detail::mmio<std::uint16_t>(0x0400'0010 + num * 4);
    }
    volatile std::uint16_t* y_scroll_addr() const noexcept
    {
-      return reinterpret_cast<std::uint16_t*>(0x0400'0012 + num * 4);
+      return detail::mmio<std::uint16_t>(0x0400'0012 + num * 4);
    }
 
    int num;
@@ -689,43 +929,51 @@ inline constexpr bg bg3{3, detail::bg_builder{}};
 
 inline volatile std::uint32_t* bg_char_loc(bg_opt::char_base_block opt) noexcept
 {
-   return reinterpret_cast<volatile std::uint32_t*>(0x600'0000 + 0x4000 * static_cast<int>(opt));
+   return detail::mmio<std::uint32_t>(0x600'0000 + 0x4000 * static_cast<int>(opt));
 }
 
 inline volatile std::uint16_t* bg_screen_loc(bg_opt::screen_base_block opt) noexcept
 {
-   return reinterpret_cast<volatile std::uint16_t*>(0x600'0000 + 0x800 * static_cast<int>(opt));
+   return detail::mmio<std::uint16_t>(0x600'0000 + 0x800 * static_cast<int>(opt));
 }
 
 inline volatile std::uint32_t* bg_screen_loc32(bg_opt::screen_base_block opt) noexcept
 {
-   return reinterpret_cast<volatile std::uint32_t*>(0x600'0000 + 0x800 * static_cast<int>(opt));
+   return detail::mmio<std::uint32_t>(0x600'0000 + 0x800 * static_cast<int>(opt));
 }
 
 inline volatile std::uint16_t* bg_palette_addr(int num) noexcept
 {
-   return reinterpret_cast<volatile std::uint16_t*>(0x500'0000 + 32 * num);
+   return detail::mmio<std::uint16_t>(0x500'0000 + 32 * num);
 }
 
 inline volatile std::uint16_t* obj_palette_addr(int num) noexcept
 {
-   return reinterpret_cast<volatile std::uint16_t*>(0x500'0200 + 32 * num);
+   return detail::mmio<std::uint16_t>(0x500'0200 + 32 * num);
 }
 
 inline volatile std::uint32_t* base_obj_tile_addr(int bg_mode) noexcept
 {
    if (bg_mode == 0 || bg_mode == 1 || bg_mode == 2) {
-      return reinterpret_cast<volatile std::uint32_t*>(0x601'0000);
+      return detail::mmio<std::uint32_t>(0x601'0000);
    }
-   return reinterpret_cast<volatile std::uint32_t*>(0x601'4000);
+   return detail::mmio<std::uint32_t>(0x601'4000);
+}
+
+// PA of one of the 32 groups of OBJ rotation/scaling parameters; they're spread through OAM, so PB, PC and PD follow
+// 8 bytes apart
+inline volatile std::int16_t* obj_affine_params_addr(int group) noexcept
+{
+   GBA_ASSERT_PARANOID(group >= 0 && group < 32);
+   return detail::mmio<std::int16_t>(0x700'0006 + 0x20 * group);
 }
 
 struct obj {
 public:
    constexpr explicit obj(int num) noexcept : num{num}
    {
-      GBA_ASSERT(num >= 0);
-      GBA_ASSERT(num < 128);
+      GBA_ASSERT_PARANOID(num >= 0);
+      GBA_ASSERT_PARANOID(num < 128);
    }
 
    void set_y(int y) const noexcept
@@ -746,7 +994,7 @@ public:
 
    void set_tile(int tile) const noexcept
    {
-      GBA_ASSERT(tile >= 0 && tile < 1024);
+      GBA_ASSERT_PARANOID(tile >= 0 && tile < 1024);
       auto val = *attr2_addr();
       val &= 0b1111'1100'0000'0000;
       val |= tile;
@@ -780,7 +1028,7 @@ public:
 
    void set_tile_and_attr2(int tile, obj_attr2_options opt) const noexcept
    {
-      GBA_ASSERT(tile >= 0 && tile < 1024);
+      GBA_ASSERT_PARANOID(tile >= 0 && tile < 1024);
       *attr2_addr() = tile | opt.or_mask;
    }
 
@@ -789,21 +1037,25 @@ private:
 
    inline volatile std::uint16_t* attr0_addr() const noexcept
    {
-      return reinterpret_cast<volatile std::uint16_t*>(0x700'0000 + 0x08 * num);
+      return detail::mmio<std::uint16_t>(0x700'0000 + 0x08 * num);
    };
    inline volatile std::uint16_t* attr1_addr() const noexcept
    {
-      return reinterpret_cast<volatile std::uint16_t*>(0x700'0002 + 0x08 * num);
+      return detail::mmio<std::uint16_t>(0x700'0002 + 0x08 * num);
    };
    inline volatile std::uint16_t* attr2_addr() const noexcept
    {
-      return reinterpret_cast<volatile std::uint16_t*>(0x700'0004 + 0x08 * num);
+      return detail::mmio<std::uint16_t>(0x700'0004 + 0x08 * num);
    };
 };
 
+// Immediate DMA 3 transfers (the host build copies directly)
 inline volatile std::uint32_t*
    dma3_copy(const std::uint32_t* start, const std::uint32_t* end, volatile std::uint32_t* dest) noexcept
 {
+#ifdef GBA_HOST
+   return std::copy(start, end, dest);
+#else
    using namespace gba::dma_opt;
    gba::dma3.set_source(start);
    gba::dma3.set_destination(dest);
@@ -817,6 +1069,7 @@ inline volatile std::uint32_t*
                             .set(irq::disable)
                             .set(enable::on));
    return dest + (end - start);
+#endif
 }
 
 inline std::uint32_t* dma3_copy(const std::uint32_t* start, const std::uint32_t* end, std::uint32_t* dest) noexcept
@@ -827,6 +1080,9 @@ inline std::uint32_t* dma3_copy(const std::uint32_t* start, const std::uint32_t*
 inline volatile std::uint16_t*
    dma3_copy(const std::uint16_t* start, const std::uint16_t* end, volatile std::uint16_t* dest) noexcept
 {
+#ifdef GBA_HOST
+   return std::copy(start, end, dest);
+#else
    using namespace gba::dma_opt;
    gba::dma3.set_source(start);
    gba::dma3.set_destination(dest);
@@ -840,6 +1096,7 @@ inline volatile std::uint16_t*
                             .set(irq::disable)
                             .set(enable::on));
    return dest + (end - start);
+#endif
 }
 
 inline std::uint16_t* dma3_copy(const std::uint16_t* start, const std::uint16_t* end, std::uint16_t* dest) noexcept
@@ -849,6 +1106,9 @@ inline std::uint16_t* dma3_copy(const std::uint16_t* start, const std::uint16_t*
 
 inline void dma3_fill(volatile std::uint32_t* start, volatile std::uint32_t* end, std::uint32_t value) noexcept
 {
+#ifdef GBA_HOST
+   std::fill(start, end, value);
+#else
    using namespace gba::dma_opt;
    gba::dma3.set_source(&value);
    gba::dma3.set_destination(start);
@@ -861,6 +1121,7 @@ inline void dma3_fill(volatile std::uint32_t* start, volatile std::uint32_t* end
                             .set(start_timing::immediate)
                             .set(irq::disable)
                             .set(enable::on));
+#endif
 }
 
 inline void dma3_fill(std::uint32_t* start, std::uint32_t* end, std::uint32_t value) noexcept
@@ -870,6 +1131,9 @@ inline void dma3_fill(std::uint32_t* start, std::uint32_t* end, std::uint32_t va
 
 inline void dma3_fill(volatile std::uint16_t* start, volatile std::uint16_t* end, std::uint16_t value) noexcept
 {
+#ifdef GBA_HOST
+   std::fill(start, end, value);
+#else
    using namespace gba::dma_opt;
    gba::dma3.set_source(&value);
    gba::dma3.set_destination(start);
@@ -882,6 +1146,7 @@ inline void dma3_fill(volatile std::uint16_t* start, volatile std::uint16_t* end
                             .set(start_timing::immediate)
                             .set(irq::disable)
                             .set(enable::on));
+#endif
 }
 
 inline void dma3_fill(std::uint16_t* start, std::uint16_t* end, std::uint16_t value) noexcept
@@ -889,11 +1154,17 @@ inline void dma3_fill(std::uint16_t* start, std::uint16_t* end, std::uint16_t va
    dma3_fill(const_cast<volatile std::uint16_t*>(start), const_cast<volatile std::uint16_t*>(end), value);
 }
 
+// KEYINPUT: a bit per key (A, B, SELECT, START, right, left, up, down, R, L), clear while the key is held
+inline std::uint16_t read_keys() noexcept { return *detail::mmio<std::uint16_t>(0x400'0130); }
+
 struct keypad_status {
-   void update()
+   void update() { update(read_keys()); }
+
+   // raw is in the KEYINPUT format
+   void update(std::uint16_t raw)
    {
       raw_val_prev = raw_val;
-      raw_val = *(volatile std::uint16_t*)(0x4000130);
+      raw_val = raw;
       const std::array<std::pair<int&, decltype(&keypad_status::prev_up_held)>, 4> repeat_info{
          {{up_counter, &keypad_status::prev_up_held},
           {down_counter, &keypad_status::prev_down_held},
@@ -974,20 +1245,51 @@ private:
    int left_counter;
 };
 
-inline bool in_vblank() noexcept { return *(volatile std::uint16_t*)(0x4000004) & 1; }
+inline bool in_vblank() noexcept
+{
+#ifdef GBA_HOST
+   return host::poll_vblank();
+#else
+   return *detail::mmio<std::uint16_t>(0x400'0004) & 1;
+#endif
+}
+
+// The scanline being drawn; 160 to 227 are VBlank
+inline int vcount() noexcept { return *detail::mmio<std::uint16_t>(0x400'0006) & 0xFF; }
+
+// With the VBlank IRQ enabled in DISPSTAT, IF records each VBlank even though interrupts are never enabled
+// so it can be checked whether a VBlank has started since the flag was last cleared
+inline void enable_vblank_flag() noexcept
+{
+   auto* const dispstat = detail::mmio<std::uint16_t>(0x400'0004);
+   *dispstat = *dispstat | (1 << 3);
+}
+
+inline bool vblank_flag() noexcept { return *detail::mmio<std::uint16_t>(0x400'0202) & 1; }
+
+// IF bits are cleared by writing 1 to them
+inline void clear_vblank_flag() noexcept
+{
+#ifdef GBA_HOST
+   host::clear_interrupt_flags(1);
+#else
+   *detail::mmio<std::uint16_t>(0x400'0202) = 1;
+#endif
+}
 
 constexpr std::uint16_t make_tile(int tile_num, int palette_num) noexcept
 {
-   GBA_ASSERT(palette_num >= 0 && palette_num < 16);
+   GBA_ASSERT_PARANOID(palette_num >= 0 && palette_num < 16);
    return tile_num | (palette_num << 12);
 }
 
 // Copy a full screen tilemap to VRAM
-inline void copy_tilemap(const std::uint16_t (&array)[600], bg_opt::screen_base_block loc) noexcept
+inline void copy_tilemap(std::span<const std::uint16_t> tiles, bg_opt::screen_base_block loc) noexcept
 {
+   GBA_ASSERT(tiles.size() == 600);
    const auto base_dest = bg_screen_loc(loc);
    for (int y = 0; y != 20; ++y) {
-      dma3_copy(array + y * 30, array + y * 30 + 30, base_dest + y * 32);
+      dma3_copy(tiles.data() + y * 30, tiles.data() + y * 30 + 30, base_dest + y * 32);
    }
 }
 
@@ -1015,22 +1317,28 @@ consteval std::uint16_t make_gba_color(std::uint8_t r, std::uint8_t g, std::uint
    return (conv(b) << 10) | (conv(g) << 5) | conv(r);
 }
 
-// This reduces the wait cycles to a minimum and enables prefetch
-// It sets SRAM wait cycles to the max because that's what's recommended in GBATEK
-inline void set_fast_mode() noexcept
-{
-   const auto ptr = reinterpret_cast<volatile std::uint16_t*>(0x400'0204);
-   *ptr = 0b0100'0110'1101'1011;
-}
+// WAITCNT: the wait states for ROM and SRAM accesses and whether the prefetch buffer is on
+inline void set_waitcnt(std::uint16_t value) noexcept { *detail::mmio<std::uint16_t>(0x400'0204) = value; }
+
+// The fewest ROM wait cycles (2 for the first access, 1 after) with prefetch
+// SRAM gets the max wait cycles because that's what's recommended in GBATEK
+inline constexpr std::uint16_t fast_waitcnt = 0b0100'0110'1101'1011;
+
+inline void set_fast_mode() noexcept { set_waitcnt(fast_waitcnt); }
 
 // Soft resets
 [[noreturn]] inline void soft_reset() noexcept
 {
+#ifdef GBA_HOST
+   // There's nothing to reset to on a host
+   std::abort();
+#else
    asm(".thumb_func\nswi 0");
    __builtin_unreachable();
+#endif
 }
 
-inline volatile std::uint8_t* sram_addr() noexcept { return reinterpret_cast<volatile std::uint8_t*>(0xE00'0000); }
+inline volatile std::uint8_t* sram_addr() noexcept { return detail::mmio<std::uint8_t>(0xE00'0000); }
 
 } // namespace gba
 
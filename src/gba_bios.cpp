@@ -0,0 +1,493 @@
+#include "gba_bios.hpp"
+
+#include "gba.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+namespace {
+
+#ifndef GBA_HOST
+
+// SWI numbers are encoded differently in ARM code, and GCC will inline Thumb functions into ARM ones (LTO included)
+#define GBA_BIOS_CALL [[gnu::noinline]] GBA_THUMB
+
+// CpuSet's control word: bits 0-20 are the number of units, bit 24 fills with the first unit and bit 26 makes units
+// 32 bits (CpuFastSet only has the fill bit)
+constexpr std::uint32_t set_fill = 1 << 24;
+constexpr std::uint32_t set_32bit = 1 << 26;
+constexpr std::uint32_t max_set_units = 0x1F'FFFF;
+
+// Every call can change r0 to r3 and r12
+GBA_THUMB void cpu_set(const volatile void* src, volatile void* dest, std::uint32_t control) noexcept
+{
+   register auto* r0 asm("r0") = src;
+   register auto* r1 asm("r1") = dest;
+   register std::uint32_t r2 asm("r2") = control;
+   asm volatile("swi 0x0B" : "+r"(r0), "+r"(r1), "+r"(r2) : : "r3", "r12", "cc", "memory");
+}
+
+GBA_THUMB void cpu_fast_set(const volatile void* src, volatile void* dest, std::uint32_t control) noexcept
+{
+   register auto* r0 asm("r0") = src;
+   register auto* r1 asm("r1") = dest;
+   register std::uint32_t r2 asm("r2") = control;
+   asm volatile("swi 0x0C" : "+r"(r0), "+r"(r1), "+r"(r2) : : "r3", "r12", "cc", "memory");
+}
+
+// The decompression calls all take the source and destination in r0 and r1
+template<int Swi>
+GBA_THUMB void decompress(const std::uint32_t* src, volatile void* dest) noexcept
+{
+   register auto* r0 asm("r0") = src;
+   register auto* r1 asm("r1") = dest;
+   asm volatile("swi %2" : "+r"(r0), "+r"(r1) : "i"(Swi) : "r2", "r3", "r12", "cc", "memory");
+}
+
+// Called by the BIOS in ARM mode with r0 = 0x400'0000; acknowledges the interrupts in IF and adds them to the flags
+// IntrWait checks (at 0x300'7FF8, which 0x3FF'FFF8 mirrors)
+[[gnu::naked]] GBA_ARM void irq_handler() noexcept
+{
+   asm volatile(
+      "add r0, r0, #0x200\n"
+      // IE | IF << 16
+      "ldr r1, [r0]\n"
+      "and r1, r1, r1, lsr #16\n"
+      "strh r1, [r0, #2]\n"
+      "sub r0, r0, #0x208\n"
+      "ldrh r2, [r0]\n"
+      "orr r2, r2, r1\n"
+      "strh r2, [r0]\n"
+      "bx lr\n");
+}
+
+#endif
+
+std::uint32_t decompressed_size(const std::uint32_t* src) noexcept { return *src >> 8; }
+
+// sin in 1.14 fixed point at the BIOS's resolution (the top 8 bits of the angle)
+std::int32_t sin14(std::uint16_t angle) noexcept
+{
+   const auto radians = static_cast<float>(angle >> 8) * (2 * std::numbers::pi_v<float> / 256);
+   return static_cast<std::int32_t>(std::lround(std::sin(radians) * 0x4000));
+}
+
+std::int32_t cos14(std::uint16_t angle) noexcept { return sin14(static_cast<std::uint16_t>(angle + 0x4000)); }
+
+} // anonymous namespace
+
+namespace gba::bios {
+
+#ifdef GBA_HOST
+
+div_result div(std::int32_t numerator, std::int32_t denominator) noexcept
+{
+   return fallback::div(numerator, denominator);
+}
+
+div_result div_arm(std::int32_t numerator, std::int32_t denominator) noexcept
+{
+   return fallback::div(numerator, denominator);
+}
+
+std::uint16_t sqrt(std::uint32_t value) noexcept { return fallback::sqrt(value); }
+
+std::uint16_t arctan2(std::int16_t x, std::int16_t y) noexcept { return fallback::arctan2(x, y); }
+
+void cpu_copy(const std::uint16_t* begin, const std::uint16_t* end, volatile std::uint16_t* dest) noexcept
+{
+   std::copy(begin, end, dest);
+}
+
+void cpu_copy(const std::uint32_t* begin, const std::uint32_t* end, volatile std::uint32_t* dest) noexcept
+{
+   std::copy(begin, end, dest);
+}
+
+void cpu_fill(volatile std::uint16_t* begin, volatile std::uint16_t* end, std::uint16_t value) noexcept
+{
+   std::fill(begin, end, value);
+}
+
+void cpu_fill(volatile std::uint32_t* begin, volatile std::uint32_t* end, std::uint32_t value) noexcept
+{
+   std::fill(begin, end, value);
+}
+
+void cpu_fast_copy(const std::uint32_t* begin, const std::uint32_t* end, volatile std::uint32_t* dest) noexcept
+{
+   GBA_ASSERT((end - begin) % 8 == 0);
+   std::copy(begin, end, dest);
+}
+
+void cpu_fast_fill(volatile std::uint32_t* begin, volatile std::uint32_t* end, std::uint32_t value) noexcept
+{
+   GBA_ASSERT((end - begin) % 8 == 0);
+   std::fill(begin, end, value);
+}
+
+// VRAM is ordinary memory in the host build, so the byte at a time versions do for every destination
+void lz77_decompress(const std::uint32_t* src, void* dest) noexcept { fallback::lz77_decompress(src, dest); }
+
+void lz77_decompress_vram(const std::uint32_t* src, volatile std::uint16_t* dest) noexcept
+{
+   fallback::lz77_decompress(src, const_cast<std::uint16_t*>(dest));
+}
+
+void rle_decompress(const std::uint32_t* src, void* dest) noexcept { fallback::rle_decompress(src, dest); }
+
+void rle_decompress_vram(const std::uint32_t* src, volatile std::uint16_t* dest) noexcept
+{
+   fallback::rle_decompress(src, const_cast<std::uint16_t*>(dest));
+}
+
+void huffman_decompress(const std::uint32_t* src, volatile std::uint32_t* dest) noexcept
+{
+   fallback::huffman_decompress(src, const_cast<std::uint32_t*>(dest));
+}
+
+void bg_affine_set(const bg_affine_source* src, bg_affine_dest* dest, int count) noexcept
+{
+   fallback::bg_affine_set(src, dest, count);
+}
+
+void obj_affine_set(const obj_affine_source* src, volatile std::int16_t* dest, int count, int stride) noexcept
+{
+   fallback::obj_affine_set(src, dest, count, stride);
+}
+
+void register_ram_reset(std::uint8_t flags) noexcept
+{
+   if (flags & reset::palette) {
+      host::state.palette.fill(0);
+   }
+   if (flags & reset::vram) {
+      host::state.vram.fill(0);
+   }
+   if (flags & reset::oam) {
+      host::state.oam.fill(0);
+   }
+}
+
+void enable_interrupts(std::uint16_t) noexcept {}
+
+// Polling VBlank flips it, so this returns straight away like the host's other VBlank waits
+void intr_wait(bool, std::uint16_t irqs) noexcept
+{
+   if (irqs & 1) {
+      vblank_intr_wait();
+   }
+}
+
+void vblank_intr_wait() noexcept
+{
+   while (!in_vblank()) {}
+}
+
+#else
+
+GBA_BIOS_CALL div_result div(std::int32_t numerator, std::int32_t denominator) noexcept
+{
+   GBA_ASSERT(denominator != 0);
+   register std::int32_t r0 asm("r0") = numerator;
+   register std::int32_t r1 asm("r1") = denominator;
+   asm volatile("swi 0x06" : "+r"(r0), "+r"(r1) : : "r2", "r3", "r12", "cc");
+   return {r0, r1};
+}
+
+GBA_BIOS_CALL div_result div_arm(std::int32_t numerator, std::int32_t denominator) noexcept
+{
+   GBA_ASSERT(denominator != 0);
+   register std::int32_t r0 asm("r0") = denominator;
+   register std::int32_t r1 asm("r1") = numerator;
+   asm volatile("swi 0x07" : "+r"(r0), "+r"(r1) : : "r2", "r3", "r12", "cc");
+   return {r0, r1};
+}
+
+GBA_BIOS_CALL std::uint16_t sqrt(std::uint32_t value) noexcept
+{
+   register std::uint32_t r0 asm("r0") = value;
+   asm volatile("swi 0x08" : "+r"(r0) : : "r1", "r2", "r3", "r12", "cc");
+   return static_cast<std::uint16_t>(r0);
+}
+
+GBA_BIOS_CALL std::uint16_t arctan2(std::int16_t x, std::int16_t y) noexcept
+{
+   register std::int32_t r0 asm("r0") = x;
+   register std::int32_t r1 asm("r1") = y;
+   asm volatile("swi 0x0A" : "+r"(r0), "+r"(r1) : : "r2", "r3", "r12", "cc");
+   return static_cast<std::uint16_t>(r0);
+}
+
+GBA_BIOS_CALL void
+   cpu_copy(const std::uint16_t* begin, const std::uint16_t* end, volatile std::uint16_t* dest) noexcept
+{
+   GBA_ASSERT(static_cast<std::uint32_t>(end - begin) <= max_set_units);
+   cpu_set(begin, dest, end - begin);
+}
+
+GBA_BIOS_CALL void
+   cpu_copy(const std::uint32_t* begin, const std::uint32_t* end, volatile std::uint32_t* dest) noexcept
+{
+   GBA_ASSERT(static_cast<std::uint32_t>(end - begin) <= max_set_units);
+   cpu_set(begin, dest, (end - begin) | set_32bit);
+}
+
+GBA_BIOS_CALL void
+   cpu_fill(volatile std::uint16_t* begin, volatile std::uint16_t* end, std::uint16_t value) noexcept
+{
+   GBA_ASSERT(static_cast<std::uint32_t>(end - begin) <= max_set_units);
+   cpu_set(&value, begin, (end - begin) | set_fill);
+}
+
+GBA_BIOS_CALL void
+   cpu_fill(volatile std::uint32_t* begin, volatile std::uint32_t* end, std::uint32_t value) noexcept
+{
+   GBA_ASSERT(static_cast<std::uint32_t>(end - begin) <= max_set_units);
+   cpu_set(&value, begin, (end - begin) | set_32bit | set_fill);
+}
+
+GBA_BIOS_CALL void
+   cpu_fast_copy(const std::uint32_t* begin, const std::uint32_t* end, volatile std::uint32_t* dest) noexcept
+{
+   // The BIOS rounds the count up to a multiple of 8 rather than stopping short
+   GBA_ASSERT((end - begin) % 8 == 0);
+   cpu_fast_set(begin, dest, end - begin);
+}
+
+GBA_BIOS_CALL void
+   cpu_fast_fill(volatile std::uint32_t* begin, volatile std::uint32_t* end, std::uint32_t value) noexcept
+{
+   GBA_ASSERT((end - begin) % 8 == 0);
+   cpu_fast_set(&value, begin, (end - begin) | set_fill);
+}
+
+GBA_BIOS_CALL void lz77_decompress(const std::uint32_t* src, void* dest) noexcept { decompress<0x11>(src, dest); }
+
+GBA_BIOS_CALL void lz77_decompress_vram(const std::uint32_t* src, volatile std::uint16_t* dest) noexcept
+{
+   decompress<0x12>(src, dest);
+}
+
+GBA_BIOS_CALL void huffman_decompress(const std::uint32_t* src, volatile std::uint32_t* dest) noexcept
+{
+   decompress<0x13>(src, dest);
+}
+
+GBA_BIOS_CALL void rle_decompress(const std::uint32_t* src, void* dest) noexcept { decompress<0x14>(src, dest); }
+
+GBA_BIOS_CALL void rle_decompress_vram(const std::uint32_t* src, volatile std::uint16_t* dest) noexcept
+{
+   decompress<0x15>(src, dest);
+}
+
+GBA_BIOS_CALL void bg_affine_set(const bg_affine_source* src, bg_affine_dest* dest, int count) noexcept
+{
+   register auto* r0 asm("r0") = src;
+   register auto* r1 asm("r1") = dest;
+   register int r2 asm("r2") = count;
+   asm volatile("swi 0x0E" : "+r"(r0), "+r"(r1), "+r"(r2) : : "r3", "r12", "cc", "memory");
+}
+
+GBA_BIOS_CALL void
+   obj_affine_set(const obj_affine_source* src, volatile std::int16_t* dest, int count, int stride) noexcept
+{
+   register auto* r0 asm("r0") = src;
+   register auto* r1 asm("r1") = dest;
+   register int r2 asm("r2") = count;
+   register int r3 asm("r3") = stride;
+   asm volatile("swi 0x0F" : "+r"(r0), "+r"(r1), "+r"(r2), "+r"(r3) : : "r12", "cc", "memory");
+}
+
+GBA_BIOS_CALL void register_ram_reset(std::uint8_t flags) noexcept
+{
+   register std::uint32_t r0 asm("r0") = flags;
+   asm volatile("swi 0x01" : "+r"(r0) : : "r1", "r2", "r3", "r12", "cc", "memory");
+}
+
+void enable_interrupts(std::uint16_t irqs) noexcept
+{
+   // Where the BIOS's interrupt handler jumps to
+   *reinterpret_cast<void (* volatile*)() noexcept>(0x300'7FFC) = irq_handler;
+   auto* const ie = detail::mmio<std::uint16_t>(0x400'0200);
+   *ie = *ie | irqs;
+   *detail::mmio<std::uint16_t>(0x400'0208) = 1;
+}
+
+GBA_BIOS_CALL void intr_wait(bool discard_old, std::uint16_t irqs) noexcept
+{
+   register std::uint32_t r0 asm("r0") = discard_old;
+   register std::uint32_t r1 asm("r1") = irqs;
+   asm volatile("swi 0x04" : "+r"(r0), "+r"(r1) : : "r2", "r3", "r12", "cc", "memory");
+}
+
+GBA_BIOS_CALL void vblank_intr_wait() noexcept
+{
+   asm volatile("swi 0x05" : : : "r0", "r1", "r2", "r3", "r12", "cc", "memory");
+}
+
+#undef GBA_BIOS_CALL
+
+#endif
+
+namespace fallback {
+
+div_result div(std::int32_t numerator, std::int32_t denominator) noexcept
+{
+   GBA_ASSERT(denominator != 0);
+   return {numerator / denominator, numerator % denominator};
+}
+
+// A bit at a time, from the top
+std::uint16_t sqrt(std::uint32_t value) noexcept
+{
+   std::uint32_t root = 0;
+   for (std::uint32_t bit = 1u << 30; bit != 0; bit >>= 2) {
+      if (value >= root + bit) {
+         value -= root + bit;
+         root = (root >> 1) + bit;
+      }
+      else {
+         root >>= 1;
+      }
+   }
+   return static_cast<std::uint16_t>(root);
+}
+
+std::uint16_t arctan2(std::int16_t x, std::int16_t y) noexcept
+{
+   const auto radians = std::atan2(static_cast<float>(y), static_cast<float>(x));
+   // Negative angles wrap round to the top half
+   return static_cast<std::uint16_t>(std::lround(radians * (0x8000 / std::numbers::pi_v<float>)));
+}
+
+// A flag byte for every 8 blocks, top bit first: a 0 bit is a literal byte and a 1 bit copies (b0 >> 4) + 3 bytes
+// from ((b0 & 0xF) << 8 | b1) + 1 bytes back
+void lz77_decompress(const std::uint32_t* src, void* dest) noexcept
+{
+   auto* out = static_cast<std::uint8_t*>(dest);
+   const auto* const end = out + decompressed_size(src);
+   const auto* in = reinterpret_cast<const std::uint8_t*>(src + 1);
+   while (out < end) {
+      auto flags = *in;
+      ++in;
+      for (int i = 0; i < 8 && out < end; ++i, flags <<= 1) {
+         if (flags & 0b1000'0000) {
+            const auto length = (in[0] >> 4) + 3;
+            const auto distance = ((in[0] & 0xF) << 8 | in[1]) + 1;
+            in += 2;
+            for (int j = 0; j < length && out < end; ++j, ++out) {
+               *out = out[-distance];
+            }
+         }
+         else {
+            *out = *in;
+            ++out;
+            ++in;
+         }
+      }
+   }
+}
+
+// A flag byte per run: with the top bit set the next byte is repeated (flag & 0x7F) + 3 times, otherwise
+// (flag & 0x7F) + 1 bytes are copied
+void rle_decompress(const std::uint32_t* src, void* dest) noexcept
+{
+   auto* out = static_cast<std::uint8_t*>(dest);
+   const auto* const end = out + decompressed_size(src);
+   const auto* in = reinterpret_cast<const std::uint8_t*>(src + 1);
+   while (out < end) {
+      const auto flag = *in;
+      ++in;
+      if (flag & 0b1000'0000) {
+         const auto length = std::min<int>((flag & 0b0111'1111) + 3, end - out);
+         out = std::fill_n(out, length, *in);
+         ++in;
+      }
+      else {
+         const auto length = std::min<int>((flag & 0b0111'1111) + 1, end - out);
+         out = std::copy_n(in, length, out);
+         in += (flag & 0b0111'1111) + 1;
+      }
+   }
+}
+
+// The tree follows the header: a byte holding its size in 16-bit units less 1, then the root node, then pairs of
+// children; a node's bits 0-5 are the offset to its pair of children (in pairs, from its own pair) and bits 7 and 6
+// are set when its 0 and 1 child are data rather than nodes
+// The bits follow the tree as 32-bit words, top bit first; data units are packed into 32-bit words bottom first
+void huffman_decompress(const std::uint32_t* src, std::uint32_t* dest) noexcept
+{
+   const auto unit_bits = static_cast<int>(*src & 0xF);
+   const auto unit_mask = (1u << unit_bits) - 1;
+   auto remaining = static_cast<std::int32_t>(decompressed_size(src));
+   const auto* const tree = reinterpret_cast<const std::uint8_t*>(src + 1);
+   const auto* bits = reinterpret_cast<const std::uint32_t*>(tree + (tree[0] + 1) * 2);
+
+   std::uint32_t word = 0;
+   int word_bits = 0;
+   int node_loc = 1;
+   while (remaining > 0) {
+      auto stream = *bits;
+      ++bits;
+      for (int i = 0; i < 32 && remaining > 0; ++i, stream <<= 1) {
+         const auto node = tree[node_loc];
+         const bool one = stream & 0x8000'0000;
+         const auto child_loc = (node_loc & ~1) + (node & 0b11'1111) * 2 + 2 + one;
+         if (!(node & (one ? 0b0100'0000 : 0b1000'0000))) {
+            node_loc = child_loc;
+            continue;
+         }
+         word |= (tree[child_loc] & unit_mask) << word_bits;
+         word_bits += unit_bits;
+         node_loc = 1;
+         if (word_bits == 32) {
+            *dest = word;
+            ++dest;
+            word = 0;
+            word_bits = 0;
+            remaining -= 4;
+         }
+      }
+   }
+}
+
+// pa = scale_x * cos, pb = -scale_x * sin, pc = scale_y * sin, pd = scale_y * cos
+// then the offset that puts orig at center
+void bg_affine_set(const bg_affine_source* src, bg_affine_dest* dest, int count) noexcept
+{
+   for (int i = 0; i < count; ++i) {
+      const auto sin = sin14(src[i].angle);
+      const auto cos = cos14(src[i].angle);
+      const auto pa = static_cast<std::int16_t>((src[i].scale_x * cos) >> 14);
+      const auto pb = static_cast<std::int16_t>(-((src[i].scale_x * sin) >> 14));
+      const auto pc = static_cast<std::int16_t>((src[i].scale_y * sin) >> 14);
+      const auto pd = static_cast<std::int16_t>((src[i].scale_y * cos) >> 14);
+      dest[i] = {pa,
+         pb,
+         pc,
+         pd,
+         src[i].orig_x - (pa * src[i].center_x + pb * src[i].center_y),
+         src[i].orig_y - (pc * src[i].center_x + pd * src[i].center_y)};
+   }
+}
+
+void obj_affine_set(const obj_affine_source* src, volatile std::int16_t* dest, int count, int stride) noexcept
+{
+   const auto step = stride / 2;
+   for (int i = 0; i < count; ++i) {
+      const auto sin = sin14(src[i].angle);
+      const auto cos = cos14(src[i].angle);
+      dest[0] = static_cast<std::int16_t>((src[i].scale_x * cos) >> 14);
+      dest[step] = static_cast<std::int16_t>(-((src[i].scale_x * sin) >> 14));
+      dest[2 * step] = static_cast<std::int16_t>((src[i].scale_y * sin) >> 14);
+      dest[3 * step] = static_cast<std::int16_t>((src[i].scale_y * cos) >> 14);
+      dest += 4 * step;
+   }
+}
+
+} // namespace fallback
+
+} // namespace gba::bios
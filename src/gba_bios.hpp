@@ -0,0 +1,131 @@
+#ifndef GBA_BIOS_HPP
+#define GBA_BIOS_HPP
+
+#include <cstdint>
+
+// Wrappers for the BIOS calls worth having (see GBATEK's BIOS functions for the details of each)
+// The host build runs the software versions in gba::bios::fallback instead, which the device bench also times the
+// BIOS against (bench/device_bench.cpp)
+// The wrappers are Thumb functions in their own file since SWI numbers are encoded differently in ARM code; they
+// can still be called from ARM code, it just costs a call
+namespace gba::bios {
+
+struct div_result {
+   std::int32_t quotient;
+   std::int32_t remainder;
+};
+
+// Div and DivArm: rounds towards zero like /; denominator must not be 0
+div_result div(std::int32_t numerator, std::int32_t denominator) noexcept;
+// The same, with the arguments in the order DivArm takes them (a few cycles quicker than div)
+div_result div_arm(std::int32_t numerator, std::int32_t denominator) noexcept;
+
+std::uint16_t sqrt(std::uint32_t value) noexcept;
+
+// The angle of (x, y) as 0 to 0xFFFF for 0 up to 2 pi; x and y are 1.14 fixed point
+std::uint16_t arctan2(std::int16_t x, std::int16_t y) noexcept;
+
+// CpuSet: copies or fills with the CPU a unit at a time (up to 0x1F'FFFF units)
+void cpu_copy(const std::uint16_t* begin, const std::uint16_t* end, volatile std::uint16_t* dest) noexcept;
+void cpu_copy(const std::uint32_t* begin, const std::uint32_t* end, volatile std::uint32_t* dest) noexcept;
+void cpu_fill(volatile std::uint16_t* begin, volatile std::uint16_t* end, std::uint16_t value) noexcept;
+void cpu_fill(volatile std::uint32_t* begin, volatile std::uint32_t* end, std::uint32_t value) noexcept;
+
+// CpuFastSet: copies or fills 8 words at a time, so the size must be a multiple of 32 bytes
+void cpu_fast_copy(const std::uint32_t* begin, const std::uint32_t* end, volatile std::uint32_t* dest) noexcept;
+void cpu_fast_fill(volatile std::uint32_t* begin, volatile std::uint32_t* end, std::uint32_t value) noexcept;
+
+// Decompression: src starts with the BIOS header (size << 8 | type) and must be 4-byte aligned, as compressed assets
+// in the archive are (see asset_handle::stored_data)
+// The plain versions write a byte at a time, so can't write to VRAM; the _vram versions write 16 bits at a time
+// The compressed data must not copy from 1 byte back for the _vram LZ77 version (scripts/bios_compress.py never does)
+void lz77_decompress(const std::uint32_t* src, void* dest) noexcept;
+void lz77_decompress_vram(const std::uint32_t* src, volatile std::uint16_t* dest) noexcept;
+void rle_decompress(const std::uint32_t* src, void* dest) noexcept;
+void rle_decompress_vram(const std::uint32_t* src, volatile std::uint16_t* dest) noexcept;
+// Writes 32 bits at a time, so can write anywhere; 4 or 8-bit data
+void huffman_decompress(const std::uint32_t* src, volatile std::uint32_t* dest) noexcept;
+
+// Scales are 8.8 fixed point and angles 0 to 0xFFFF for 0 up to 2 pi (only the top 8 bits are used)
+struct bg_affine_source {
+   // The texture coordinates (24.8) that end up at center
+   std::int32_t orig_x;
+   std::int32_t orig_y;
+   // In screen pixels
+   std::int16_t center_x;
+   std::int16_t center_y;
+   std::int16_t scale_x;
+   std::int16_t scale_y;
+   std::uint16_t angle;
+};
+static_assert(sizeof(bg_affine_source) == 20);
+
+// Laid out as BG2PA to BG2Y (and BG3PA to BG3Y) so it can be copied straight to them
+struct bg_affine_dest {
+   std::int16_t pa;
+   std::int16_t pb;
+   std::int16_t pc;
+   std::int16_t pd;
+   std::int32_t dx;
+   std::int32_t dy;
+};
+static_assert(sizeof(bg_affine_dest) == 16);
+
+struct obj_affine_source {
+   std::int16_t scale_x;
+   std::int16_t scale_y;
+   std::uint16_t angle;
+   std::uint16_t unused;
+};
+static_assert(sizeof(obj_affine_source) == 8);
+
+void bg_affine_set(const bg_affine_source* src, bg_affine_dest* dest, int count) noexcept;
+// Writes PA, PB, PC and PD for each source, stride bytes apart: 2 to pack them, or 8 to write straight to OAM
+// (starting at gba::obj_affine_params_addr)
+void obj_affine_set(const obj_affine_source* src, volatile std::int16_t* dest, int count, int stride) noexcept;
+
+// RegisterRamReset flags
+namespace reset {
+inline constexpr std::uint8_t ewram = 1 << 0;
+// All but the last 0x200 bytes, which hold the stack
+inline constexpr std::uint8_t iwram = 1 << 1;
+inline constexpr std::uint8_t palette = 1 << 2;
+inline constexpr std::uint8_t vram = 1 << 3;
+inline constexpr std::uint8_t oam = 1 << 4;
+inline constexpr std::uint8_t sio_registers = 1 << 5;
+inline constexpr std::uint8_t sound_registers = 1 << 6;
+inline constexpr std::uint8_t other_registers = 1 << 7;
+} // namespace reset
+
+// Clears memory and registers; EWRAM and IWRAM hold the game's variables, so are only safe to clear before anything
+// uses them (the host build only clears palette, VRAM and OAM)
+void register_ram_reset(std::uint8_t flags) noexcept;
+
+// IntrWait and VBlankIntrWait halt the CPU until an interrupt, which needs interrupts to be on
+// The game polls instead (the frame monitor reads VBlanks from IF, which an interrupt handler would clear), so
+// nothing is set up until enable_interrupts is called; it installs a handler that acknowledges each interrupt and
+// records it for these calls, then enables the given interrupts (IE bits) and IME
+// The VBlank interrupt also needs gba::enable_vblank_flag
+void enable_interrupts(std::uint16_t irqs) noexcept;
+// Waits for any of irqs (IE bits); with discard_old set, ones that happened before the call don't count
+void intr_wait(bool discard_old, std::uint16_t irqs) noexcept;
+void vblank_intr_wait() noexcept;
+
+// The software versions, for the host build and for comparing against the BIOS
+// They write a byte at a time where the BIOS versions do, so have the same limits
+namespace fallback {
+
+div_result div(std::int32_t numerator, std::int32_t denominator) noexcept;
+std::uint16_t sqrt(std::uint32_t value) noexcept;
+std::uint16_t arctan2(std::int16_t x, std::int16_t y) noexcept;
+void lz77_decompress(const std::uint32_t* src, void* dest) noexcept;
+void rle_decompress(const std::uint32_t* src, void* dest) noexcept;
+void huffman_decompress(const std::uint32_t* src, std::uint32_t* dest) noexcept;
+void bg_affine_set(const bg_affine_source* src, bg_affine_dest* dest, int count) noexcept;
+void obj_affine_set(const obj_affine_source* src, volatile std::int16_t* dest, int count, int stride) noexcept;
+
+} // namespace fallback
+
+} // namespace gba::bios
+
+#endif // GBA_BIOS_HPP
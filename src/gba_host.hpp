@@ -0,0 +1,105 @@
+#ifndef GBA_HOST_HPP
+#define GBA_HOST_HPP
+
+// The host backend for gba.hpp, used when GBA_HOST is defined (see the host build in CMakeLists.txt)
+// Memory-mapped addresses are redirected to ordinary arrays so game logic can run and be tested on a PC
+// Nothing here emulates the hardware; registers just hold whatever was last written, apart from the few
+// that the game polls (VBlank, VCOUNT, IF and the keypad)
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace gba::host {
+
+struct memory {
+   alignas(4) std::array<std::uint8_t, 0x400> io;
+   alignas(4) std::array<std::uint8_t, 0x400> palette;
+   alignas(4) std::array<std::uint8_t, 0x1'8000> vram;
+   alignas(4) std::array<std::uint8_t, 0x400> oam;
+   alignas(4) std::array<std::uint8_t, 0x1'0000> sram;
+};
+
+namespace detail {
+
+inline std::uint16_t& io16(memory& mem, std::uintptr_t offset) noexcept
+{
+   return *reinterpret_cast<std::uint16_t*>(mem.io.data() + offset);
+}
+
+// How the hardware starts: SRAM reads 0xFF when it's never been written and no keys are held
+// (keypad bits read as 1 when released)
+inline memory initial_memory() noexcept
+{
+   memory mem{};
+   mem.sram.fill(0xFF);
+   io16(mem, 0x130) = 0x3FF;
+   return mem;
+}
+
+} // namespace detail
+
+inline memory state = detail::initial_memory();
+
+inline void reset() noexcept { state = detail::initial_memory(); }
+
+// Bits as in the keypad register: A, B, SELECT, START, right, left, up, down, R, L
+inline void set_keys_held(std::uint16_t held) noexcept { detail::io16(state, 0x130) = ~held & 0x3FF; }
+
+inline std::uint8_t* translate(std::uintptr_t addr) noexcept
+{
+   const auto offset = addr & 0xFF'FFFF;
+   const auto check = [](auto& region, std::uintptr_t offset_) {
+      if (offset_ >= region.size()) {
+         std::abort();
+      }
+      return region.data() + offset_;
+   };
+   switch (addr >> 24) {
+   case 0x4: return check(state.io, offset);
+   case 0x5: return check(state.palette, offset);
+   case 0x6: return check(state.vram, offset);
+   case 0x7: return check(state.oam, offset);
+   case 0xE: return check(state.sram, offset);
+   default: std::abort();
+   }
+}
+
+// Each poll flips between VBlank and drawing so wait loops finish straight away
+// Every VBlank starts at line 160 and raises IF's VBlank bit if DISPSTAT asks for it
+inline bool poll_vblank() noexcept
+{
+   auto& dispstat = detail::io16(state, 0x004);
+   dispstat ^= 1;
+   const bool vblank = dispstat & 1;
+   detail::io16(state, 0x006) = vblank ? 160 : 0;
+   if (vblank && (dispstat & (1 << 3))) {
+      detail::io16(state, 0x202) |= 1;
+   }
+   return vblank;
+}
+
+// IF bits are cleared by writing 1 to them, which a plain array can't do by itself
+inline void clear_interrupt_flags(std::uint16_t flags) noexcept { detail::io16(state, 0x202) &= ~flags; }
+
+// Wall clock time in GBA cycles (2^24 per second)
+inline std::uint32_t cycle_count() noexcept
+{
+   const auto now = std::chrono::steady_clock::now().time_since_epoch();
+   const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+   // Only differences between counts are meaningful, so wrapping is fine
+   return static_cast<std::uint32_t>(static_cast<std::uint64_t>(static_cast<double>(ns) * 0.016'777'216));
+}
+
+// Failed asserts say where they were and abort
+[[noreturn]] inline void assert_failed(const char* file, int line, const char* expression) noexcept
+{
+   std::fprintf(stderr, "%s:%d: assertion failed: %s\n", file, line, expression);
+   std::abort();
+}
+
+} // namespace gba::host
+
+#endif // GBA_HOST_HPP
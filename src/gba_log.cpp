@@ -0,0 +1,148 @@
+#include "gba_log.hpp"
+
+#include "gba.hpp"
+#include "save_data.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+using gba::log::level;
+
+struct entry {
+   std::uint16_t sequence;
+   level message_level;
+   std::uint8_t length;
+   // Always has room for a NUL after the text
+   std::array<char, gba::log::max_message_size> text;
+};
+static_assert(sizeof(entry) == 64);
+
+// Once it's full the oldest entries are overwritten, flushed or not
+constexpr int ring_size = 32;
+
+GBA_EWRAM_BSS std::array<entry, ring_size> ring;
+std::uint16_t next_sequence = 0;
+std::uint16_t flushed_sequence = 0;
+
+// SRAM ring, kept across boots so a log from the field can be read off the save:
+//    char magic[4]        'P', 'K', 'L', '1'
+//    u16 next_slot        the slot the next entry goes in, so the oldest entry is in this slot once they've wrapped
+//    u16 num_slots
+//    followed by num_slots entries of: u16 sequence, u8 level, u8 length, char text[60]
+// Sequence numbers restart with each boot
+constexpr int sram_log_offset = 0x7A10;
+constexpr int sram_log_slots = 16;
+
+struct sram_log_header {
+   std::array<char, 4> magic;
+   std::uint16_t next_slot;
+   std::uint16_t num_slots;
+};
+
+constexpr std::array<char, 4> sram_log_magic{'P', 'K', 'L', '1'};
+constexpr int sram_log_size = sizeof(sram_log_header) + sram_log_slots * sizeof(entry);
+static_assert(sram_log_offset >= save_data_end);
+static_assert(sram_log_offset + sram_log_size <= 0x8000);
+
+#ifndef GBA_HOST
+
+enum struct destination : std::uint8_t {
+   unknown,
+   mgba,
+   sram
+};
+
+destination log_destination = destination::unknown;
+int sram_next_slot = 0;
+
+// mGBA's debug registers: writing 0xC0DE to the enable register makes it read back 0x1DEA
+// A message is written to the string buffer (NUL terminated) then printed by writing its level | 0x100 to flags
+volatile std::uint16_t* mgba_debug_enable() noexcept { return gba::detail::mmio<std::uint16_t>(0x4FF'F780); }
+volatile std::uint16_t* mgba_debug_flags() noexcept { return gba::detail::mmio<std::uint16_t>(0x4FF'F700); }
+volatile char* mgba_debug_string() noexcept { return gba::detail::mmio<char>(0x4FF'F600); }
+
+destination find_destination() noexcept
+{
+   *mgba_debug_enable() = 0xC0DE;
+   if (*mgba_debug_enable() == 0x1DEA) {
+      return destination::mgba;
+   }
+   const auto header = sram_read<sram_log_header>(gba::sram_addr() + sram_log_offset);
+   if (header.magic == sram_log_magic && header.num_slots == sram_log_slots && header.next_slot < sram_log_slots) {
+      sram_next_slot = header.next_slot;
+   }
+   return destination::sram;
+}
+
+void send_to_mgba(const entry& message) noexcept
+{
+   const auto string = mgba_debug_string();
+   for (int i = 0; i < message.length; ++i) {
+      string[i] = message.text[i];
+   }
+   string[message.length] = '\0';
+   *mgba_debug_flags() = static_cast<std::uint16_t>(message.message_level) | 0x100;
+}
+
+void send_to_sram(const entry& message) noexcept
+{
+   const auto loc = gba::sram_addr() + sram_log_offset;
+   sram_write(message, loc + sizeof(sram_log_header) + sram_next_slot * sizeof(entry));
+   sram_next_slot = (sram_next_slot + 1) % sram_log_slots;
+   sram_write(sram_log_header{sram_log_magic, static_cast<std::uint16_t>(sram_next_slot), sram_log_slots}, loc);
+}
+
+void send(const entry& message) noexcept
+{
+   if (log_destination == destination::unknown) {
+      log_destination = find_destination();
+   }
+   if (log_destination == destination::mgba) {
+      send_to_mgba(message);
+   }
+   else {
+      send_to_sram(message);
+   }
+}
+
+#else
+
+void send(const entry& message) noexcept
+{
+   constexpr std::array<const char*, 5> level_names{"fatal", "error", "warn", "info", "debug"};
+   std::fprintf(stderr, "[%s] %.*s\n", level_names[static_cast<int>(message.message_level)], message.length,
+      message.text.data());
+}
+
+#endif
+
+} // anonymous namespace
+
+namespace gba::log {
+
+void write(level message_level, std::string_view message) noexcept
+{
+   auto& slot = ring[next_sequence % ring_size];
+   slot.sequence = next_sequence;
+   slot.message_level = message_level;
+   slot.length = std::min<std::size_t>(message.size(), slot.text.size() - 1);
+   std::copy_n(message.begin(), slot.length, slot.text.begin());
+   ++next_sequence;
+}
+
+void flush() noexcept
+{
+   // Entries that have been overwritten are lost
+   if (static_cast<std::uint16_t>(next_sequence - flushed_sequence) > ring_size) {
+      flushed_sequence = next_sequence - ring_size;
+   }
+   for (; flushed_sequence != next_sequence; ++flushed_sequence) {
+      send(ring[flushed_sequence % ring_size]);
+   }
+}
+
+} // namespace gba::log
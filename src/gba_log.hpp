@@ -0,0 +1,62 @@
+#ifndef GBA_LOG_HPP
+#define GBA_LOG_HPP
+
+#include "fmt/core.h"
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// Debug log: GBA_LOG(level, format, args...) formats a message into a fixed ring of entries in EWRAM
+// Nothing allocates, and messages longer than an entry are cut short
+// wait_vblank_and_update flushes new entries once a frame: to mGBA's debug log when running in mGBA, to stderr in
+// the host build, and otherwise to a ring in SRAM after the save files (scripts/decode_log_sram.py reads it)
+// Levels above GBA_LOG_LEVEL are compiled out, arguments and all; it defaults to warn in release builds and debug
+// otherwise
+namespace gba::log {
+
+// Numbered as mGBA's log levels
+enum struct level : std::uint8_t {
+   fatal,
+   error,
+   warn,
+   info,
+   debug
+};
+
+#ifndef GBA_LOG_LEVEL
+   #ifdef NDEBUG
+      #define GBA_LOG_LEVEL 2
+   #else
+      #define GBA_LOG_LEVEL 4
+   #endif
+#endif
+
+inline constexpr auto max_level = static_cast<level>(GBA_LOG_LEVEL);
+
+// Including the NUL
+inline constexpr int max_message_size = 60;
+
+void write(level message_level, std::string_view message) noexcept;
+
+template <typename... Args>
+void print(level message_level, fmt::format_string<Args...> format, Args&&... args) noexcept
+{
+   char buffer[max_message_size];
+   const auto end = fmt::format_to_n(buffer, std::size(buffer) - 1, format, std::forward<Args>(args)...);
+   write(message_level, {buffer, end.out});
+}
+
+// Sends entries written since the last flush on; cheap when there aren't any
+void flush() noexcept;
+
+} // namespace gba::log
+
+#define GBA_LOG(message_level, ...)                                                  \
+   do {                                                                              \
+      if constexpr (gba::log::level::message_level <= gba::log::max_level) {         \
+         gba::log::print(gba::log::level::message_level, __VA_ARGS__);               \
+      }                                                                              \
+   } while (false)
+
+#endif // GBA_LOG_HPP
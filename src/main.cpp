@@ -1,31 +1,29 @@
-#include "generated/bg_pal2.hpp"
-#include "generated/bg_pal3.hpp"
-#include "generated/file_select.hpp"
-#include "generated/font.hpp"
-#include "generated/naming_screen.hpp"
-#include "generated/obj_pal1.hpp"
-#include "generated/obj_pal2.hpp"
-#include "generated/stats_screen.hpp"
-#include "generated/test_tileset.hpp"
-#include "generated/title.hpp"
-#include "generated/win_screen.hpp"
-
+#include "alloc_check.hpp"
+#include "assets.hpp"
 #include "battle.hpp"
 #include "classes.hpp"
 #include "common_funcs.hpp"
 #include "constants.hpp"
+#include "crash_screen.hpp"
 #include "data.hpp"
 #include "fmt/core.h"
+#include "frame_monitor.hpp"
 #include "gba.hpp"
 #include "map_data.hpp"
+#include "overlay.hpp"
 #include "pathfinding.hpp"
+#include "perf_run.hpp"
+#include "profiler.hpp"
 #include "save_data.hpp"
+#include "save_format.hpp"
+#include "stack_monitor.hpp"
 #include "static_vector.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cstring>
 #include <limits>
+#include <optional>
 #include <span>
 #include <tuple>
 #include <utility>
@@ -36,26 +34,26 @@ enum struct title_selection {
 };
 
 global_save_data global_data;
-[[gnu::section(".ewram")]] file_save_data save_data;
-[[gnu::section(".ewram")]] file_save_data backup_data;
+GBA_EWRAM_DATA file_save_data save_data;
+// What's in SRAM for the last file loaded or saved so saving to it again only writes what's changed
+GBA_EWRAM_DATA file_cache save_cache;
 
 // Sets up common palettes and tiles used for most places
 void common_tile_and_palette_setup()
 {
    gba::bg0.set_scroll(0, 0);
    // Load tiles in
-   const auto start_tileset
-      = gba::dma3_copy(std::begin(font), std::end(font), gba::bg_char_loc(gba::bg_opt::char_base_block::b0));
-   const auto start_move_indic = gba::dma3_copy(std::begin(test_tileset), std::end(test_tileset), start_tileset);
-   gba::dma3_copy(std::begin(bg_pal2::move_indicator), std::end(bg_pal2::move_indicator), start_move_indic);
+   const auto start_tileset = load_asset(asset_id::font, gba::bg_char_loc(gba::bg_opt::char_base_block::b0));
+   const auto start_move_indic = load_asset(asset_id::test_tileset, start_tileset);
+   load_asset(asset_id::bg_pal2_move_indicator, start_move_indic);
    // Load palettes in
-   gba::dma3_copy(std::begin(font_pal), std::end(font_pal), gba::bg_palette_addr(0));
-   gba::dma3_copy(std::begin(test_tileset_pal), std::end(test_tileset_pal), gba::bg_palette_addr(1));
-   gba::dma3_copy(std::begin(bg_pal2::palette), std::end(bg_pal2::palette), gba::bg_palette_addr(2));
-   gba::dma3_copy(std::begin(bg_pal3::palette), std::end(bg_pal3::palette), gba::bg_palette_addr(3));
-   gba::dma3_copy(std::begin(font_pal), std::end(font_pal), gba::obj_palette_addr(0));
-   gba::dma3_copy(std::begin(obj_pal1::palette), std::end(obj_pal1::palette), gba::obj_palette_addr(1));
-   gba::dma3_copy(std::begin(obj_pal2::palette), std::end(obj_pal2::palette), gba::obj_palette_addr(2));
+   load_asset(asset_id::font_pal, gba::bg_palette_addr(0));
+   load_asset(asset_id::test_tileset_pal, gba::bg_palette_addr(1));
+   load_asset(asset_id::bg_pal2_palette, gba::bg_palette_addr(2));
+   load_asset(asset_id::bg_pal3_palette, gba::bg_palette_addr(3));
+   load_asset(asset_id::font_pal, gba::obj_palette_addr(0));
+   load_asset(asset_id::obj_pal1_palette, gba::obj_palette_addr(1));
+   load_asset(asset_id::obj_pal2_palette, gba::obj_palette_addr(2));
 }
 
 void victory_screen() noexcept
@@ -76,7 +74,7 @@ void victory_screen() noexcept
                               .set(display_window_obj::off)
                               .set(obj_char_mapping::one_dimensional));
    }
-   gba::dma3_copy(std::begin(win_screen), std::end(win_screen), gba::bg_screen_loc(gba::bg_opt::screen_base_block::b0));
+   load_asset(asset_id::win_screen, gba::bg_screen_loc(gba::bg_opt::screen_base_block::b0));
    while (true) {
       const auto& keypad = wait_vblank_and_update(save_data);
 
@@ -88,11 +86,12 @@ void victory_screen() noexcept
 
 title_selection title_screen() noexcept
 {
+   const frame_monitor::scene_scope title_scene{frame_scene::title};
    gba::lcd.set_options(gba::lcd_options{}.set(gba::lcd_opt::forced_blank::on));
 
-   gba::dma3_copy(std::begin(font), std::end(font), gba::base_obj_tile_addr(3));
-   gba::dma3_copy(std::begin(font_pal), std::end(font_pal), gba::obj_palette_addr(0));
-   gba::dma3_copy(std::begin(title), std::end(title), gba::bg_screen_loc(gba::bg_opt::screen_base_block::b0));
+   load_asset(asset_id::font, gba::base_obj_tile_addr(3));
+   load_asset(asset_id::font_pal, gba::obj_palette_addr(0));
+   load_asset(asset_id::title, gba::bg_screen_loc(gba::bg_opt::screen_base_block::b0));
    gba::bg3.set_options(gba::bg_options{}.set(gba::bg_opt::priority::p3));
 
    // Disable all sprites to be safe
@@ -125,8 +124,9 @@ title_selection title_screen() noexcept
 
    // Set the arrow to continue instead of new game if any files exist
    int arrow_loc = 0;
-   for (int i = 0; i < 4; ++i) {
-      if (file_exists(i)) {
+   const auto directory = read_file_directory();
+   for (int i = 0; i < num_usable_file_slots; ++i) {
+      if (directory[i].exists) {
          arrow_loc = 1;
          break;
       }
@@ -186,7 +186,7 @@ title_selection title_screen() noexcept
 
 int select_file_data(const char* prompt_finish, bool file_must_exist) noexcept
 {
-   constexpr std::array<std::pair<std::uint8_t, std::uint8_t>, 4> arrow_pos{
+   constexpr std::array<std::pair<std::uint8_t, std::uint8_t>, num_file_slots> arrow_pos{
       {{3 * 8, 5 * 8}, {18 * 8, 5 * 8}, {3 * 8, 13 * 8}, {18 * 8, 13 * 8}}};
 
    disable_all_sprites();
@@ -201,7 +201,7 @@ int select_file_data(const char* prompt_finish, bool file_must_exist) noexcept
                               .set(screen_base_block::b62)
                               .set(display_area_overflow::transparent)
                               .set(screen_size::text_256x256));
-      gba::copy_tilemap(file_select, screen_base_block::b62);
+      gba::copy_tilemap(asset_handle{asset_id::file_select}.data<std::uint16_t>(), screen_base_block::b62);
    }
 
    const auto write_bg0 = [&](const char* c, int x, int y) { write_at(gba::bg_opt::screen_base_block::b62, c, x, y); };
@@ -213,8 +213,9 @@ int select_file_data(const char* prompt_finish, bool file_must_exist) noexcept
    const auto arrow_obj = gba::obj{0};
    const auto global_data = get_global_save_data();
    int arrow_loc = global_data.last_file_select;
-   arrow_loc = std::clamp(arrow_loc, 0, 3);
-   gba::dma3_copy(std::begin(font) + arrow_offset, std::end(font) + arrow_offset + 8, gba::base_obj_tile_addr(0));
+   arrow_loc = std::clamp(arrow_loc, 0, num_usable_file_slots - 1);
+   const auto font = asset_handle{asset_id::font}.data<std::uint32_t>();
+   gba::dma3_copy(font.data() + arrow_offset, font.data() + arrow_offset + 8, gba::base_obj_tile_addr(0));
 
    {
       using namespace gba::obj_opt;
@@ -230,16 +231,22 @@ int select_file_data(const char* prompt_finish, bool file_must_exist) noexcept
    }
 
    // Set up data if it exists
-   for (int i = 0; i < 4; ++i) {
+   const auto directory = read_file_directory();
+   for (int i = 0; i < num_file_slots; ++i) {
       const auto base_loc = arrow_pos[i];
-      if (file_exists(i)) {
-         const auto data = get_file_load_data(i);
+      const auto& data = directory[i];
+      if (i >= num_usable_file_slots) {
+         write_bg0("(Reserved)", base_loc.first / 8, base_loc.second / 8 + 3);
+      }
+      else if (data.exists) {
          write_bg0(data.file_name.data(), base_loc.first / 8 - 2, base_loc.second / 8 + 2);
          const auto frame_str = frames_to_time(data.frame_count);
          char buffer[14];
          buffer[13] = '\0';
          fmt::format_to_n(buffer, std::size(buffer) - 1, "{: >13}", frame_str.data());
          write_bg0(buffer, base_loc.first / 8 - 2, base_loc.second / 8 + 3);
+         fmt::format_to_n(buffer, std::size(buffer) - 1, "Ch.{: <10}", data.chapter + 1);
+         write_bg0(buffer, base_loc.first / 8 - 2, base_loc.second / 8 + 4);
          fmt::format_to_n(buffer, std::size(buffer) - 1, "Lv.{: <10}", data.file_level);
          write_bg0(buffer, base_loc.first / 8 - 2, base_loc.second / 8 + 5);
       }
@@ -280,10 +287,10 @@ int select_file_data(const char* prompt_finish, bool file_must_exist) noexcept
          arrow_loc += 1;
       }
 
-      arrow_loc = std::clamp(arrow_loc, 0, 3);
+      arrow_loc = std::clamp(arrow_loc, 0, num_usable_file_slots - 1);
 
       if (keypad.a_pressed()) {
-         if (!file_must_exist || file_exists(arrow_loc)) {
+         if (!file_must_exist || directory[arrow_loc].exists) {
             return arrow_loc;
          }
       }
@@ -320,7 +327,7 @@ std::array<char, 16> do_naming_screen(const char* prompt, int max_length) noexce
                               .set(screen_base_block::b62)
                               .set(display_area_overflow::transparent)
                               .set(screen_size::text_256x256));
-      gba::copy_tilemap(naming_screen, screen_base_block::b62);
+      gba::copy_tilemap(asset_handle{asset_id::naming_screen}.data<std::uint16_t>(), screen_base_block::b62);
    }
    {
       using namespace gba::lcd_opt;
@@ -339,7 +346,8 @@ std::array<char, 16> do_naming_screen(const char* prompt, int max_length) noexce
    }
 
    const auto arrow_offset = 8 * font_chars::arrow;
-   gba::dma3_copy(std::begin(font) + arrow_offset, std::end(font) + arrow_offset + 8, gba::base_obj_tile_addr(0));
+   const auto font = asset_handle{asset_id::font}.data<std::uint32_t>();
+   gba::dma3_copy(font.data() + arrow_offset, font.data() + arrow_offset + 8, gba::base_obj_tile_addr(0));
 
    const auto write_bg0 = [&](const char* c, int x, int y) { write_at(gba::bg_opt::screen_base_block::b62, c, x, y); };
    const auto write_bg0_n
@@ -422,13 +430,17 @@ std::array<char, 16> do_naming_screen(const char* prompt, int max_length) noexce
    }
 }
 
+// Returns the file loaded, -1 if nothing was picked or -2 if the file couldn't be read
+// save_data is only changed if the file was loaded
 int load_game() noexcept
 {
    const auto loc = select_file_data("to load from.", true);
    if (loc != -1) {
       global_data.last_file_select = loc;
       write_global_save_data(global_data);
-      save_data = sram_read<file_save_data>(file_save_loc(loc));
+      if (!load_file(loc, save_data, save_cache)) {
+         return -2;
+      }
    }
    return loc;
 }
@@ -451,10 +463,26 @@ void main_game_loop() noexcept
    gba::bg0.set_scroll(0, 0);
    int opt = 0;
    int enemy_strength = 0;
+   // Shown once after saving or a failed load
+   std::optional<int> save_bytes_written;
+   bool load_failed = false;
    while (true) {
       constexpr const char* main_options[]{"Map", "Shop", "Equip", "Re-order", "New char", "Load", "Save"};
       const auto start_screen = gba::bg_screen_loc(gba::bg_opt::screen_base_block::b62);
       gba::dma3_fill(start_screen, start_screen + 32 * 32, ' ');
+      if (save_bytes_written == -1) {
+         write_at(gba::bg_opt::screen_base_block::b62, "Save failed (file too large)", 0, 19);
+      }
+      else if (save_bytes_written) {
+         char buffer[31]{};
+         fmt::format_to_n(buffer, std::size(buffer) - 1, "Saved ({} bytes written)", *save_bytes_written);
+         write_at(gba::bg_opt::screen_base_block::b62, buffer, 0, 19);
+      }
+      else if (load_failed) {
+         write_at(gba::bg_opt::screen_base_block::b62, "Load failed (file is corrupt)", 0, 19);
+      }
+      save_bytes_written.reset();
+      load_failed = false;
       opt = menu(save_data, std::span{main_options}, 0, 0, opt, false);
       switch (opt) {
       // Map
@@ -505,8 +533,9 @@ void main_game_loop() noexcept
                      true,
                      adjust_enemy_strength);
                   if (map_choice != -1) {
-                     backup_data = save_data;
-                     if (do_battle(save_data, get_map_data_and_enemies(ch_choice, map_choice), enemy_strength)) {
+                     // The play time is as good a source of entropy as any
+                     const auto seed = static_cast<std::uint32_t>(save_data.frame_count);
+                     if (do_battle(save_data, get_map_data_and_enemies(ch_choice, map_choice), enemy_strength, seed)) {
                         if (ch_choice == save_data.chapter && map_choice == save_data.chapter_progress) {
                            save_data.chapter_progress += 1;
                            if (save_data.chapter_progress == 9) {
@@ -533,10 +562,6 @@ void main_game_loop() noexcept
                            }
                         }
                      }
-                     else {
-                        // Load the old data
-                        save_data = backup_data;
-                     }
                      gba::bg0.set_scroll(0, 0);
                   }
                }
@@ -584,7 +609,7 @@ void main_game_loop() noexcept
       case 4: break;
       // Load
       case 5:
-         load_game();
+         load_failed = load_game() == -2;
          disable_all_sprites();
          break;
       // Save
@@ -596,10 +621,12 @@ void main_game_loop() noexcept
                = std::find_if(save_data.characters.begin(), save_data.characters.end(), [](const auto& c) {
                     return c.class_ == class_ids::snake;
                  });
-            save_data.file_level = snake_it->level;
+            if (snake_it != save_data.characters.end()) {
+               save_data.file_level = snake_it->level;
+            }
             global_data.last_file_select = loc;
             write_global_save_data(global_data);
-            sram_write(save_data, file_save_loc(loc));
+            save_bytes_written = save_file(loc, save_data, save_cache);
          }
          disable_all_sprites();
       } break;
@@ -609,12 +636,22 @@ void main_game_loop() noexcept
 
 int main()
 {
+   stack_monitor::start();
    gba::set_fast_mode();
+   crash_screen::install();
+   // For the profiler and the battle telemetry
+   gba::start_cycle_counter();
+   profiler::start();
+   frame_monitor::start();
+   perf_run::start();
+   // Battles swap in their own overlay and put this one back when they return
+   load_overlay(overlay_id::menus);
+   alloc_check::startup_finished();
    while (true) {
       const auto selection = title_screen();
       common_tile_and_palette_setup();
       if (selection == title_selection::continue_) {
-         if (load_game() != -1) {
+         if (load_game() >= 0) {
             main_game_loop();
          }
       }
@@ -624,7 +661,7 @@ int main()
          auto& snake = save_data.characters[0];
          snake.bases = class_data[class_ids::snake].stats;
          snake.level = 1;
-         snake.calc_stats(false);
+         snake.calc_stats(nullptr);
          snake.fully_heal();
          snake.class_ = class_ids::snake;
          snake.name = do_naming_screen("Name a snake!", 13);
@@ -633,7 +670,7 @@ int main()
             auto& minion = save_data.characters[i];
             minion.bases = class_data[class_ids::snake_minion].stats;
             minion.level = 1;
-            minion.calc_stats(false);
+            minion.calc_stats(nullptr);
             minion.fully_heal();
             minion.class_ = class_ids::snake_minion;
             minion.exists = true;
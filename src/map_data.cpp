@@ -1,6 +1,7 @@
 #include "map_data.hpp"
 
 #include "classes.hpp"
+#include "constants.hpp"
 
 #include "generated/arena.hpp"
 #include "generated/cross.hpp"
@@ -9,9 +10,13 @@
 
 #include <array>
 
-constexpr auto start_map_tileset = 128;
 constexpr auto map_palette = 1;
-constexpr auto maps_per_chapter = 9;
+
+// The map tiles are rebased when the assets are built, so make sure they agree with where the tileset is loaded
+static_assert(test_map_tile_offset == tile_locs::start_tileset && test_map_palette == map_palette);
+static_assert(test_layers_tile_offset == tile_locs::start_tileset && test_layers_palette == map_palette);
+static_assert(cross_tile_offset == tile_locs::start_tileset && cross_palette == map_palette);
+static_assert(arena_tile_offset == tile_locs::start_tileset && arena_palette == map_palette);
 
 constexpr std::array<const char*, maps_per_chapter * num_chapters> map_names{{
    // Chapter 1
@@ -31,15 +36,15 @@ constexpr std::array<const char*, maps_per_chapter * num_chapters> map_names{{
 
 constexpr std::array<map_data, maps_per_chapter * num_chapters> map_data_array{
    {// Chapter 1
-    test_map.rebase_map(start_map_tileset, map_palette),
-    test_layers.rebase_map(start_map_tileset, map_palette),
-    test_map.rebase_map(start_map_tileset, map_palette),
-    test_layers.rebase_map(start_map_tileset, map_palette),
-    cross.rebase_map(start_map_tileset, map_palette),
-    test_map.rebase_map(start_map_tileset, map_palette),
-    cross.rebase_map(start_map_tileset, map_palette),
-    arena.rebase_map(start_map_tileset, map_palette),
-    arena.rebase_map(start_map_tileset, map_palette)}};
+    test_map,
+    test_layers,
+    test_map,
+    test_layers,
+    cross,
+    test_map,
+    cross,
+    arena,
+    arena}};
 
 constexpr std::array<std::pair<std::int8_t, std::int8_t>, maps_per_chapter * num_chapters> base_locs{{// Chapter 1
                                                                                                       {0, 6},
@@ -111,5 +116,10 @@ full_map_info get_map_data_and_enemies(int chapter, int map) noexcept
 {
    const auto data_loc = chapter * maps_per_chapter + map;
    const auto loc = base_locs[data_loc];
-   return full_map_info{loc.first, loc.second, &map_data_array[data_loc], std::span{map_enemies[data_loc]}};
+   return full_map_info{
+      loc.first,
+      loc.second,
+      &map_data_array[data_loc],
+      std::span{map_enemies[data_loc]},
+      static_cast<std::uint8_t>(data_loc)};
 }
@@ -14,27 +14,17 @@ inline constexpr auto map_data_max_width = 16;
 inline constexpr auto tilemap_width = 60;
 inline constexpr auto tilemap_height = 40;
 inline constexpr auto num_chapters = 1;
+inline constexpr auto maps_per_chapter = 9;
 inline constexpr auto max_enemies = 12;
 inline constexpr auto max_player_units_on_map = 8;
 
-// This is a common enough operation to have a function for it
-template<typename T, std::size_t Size>
-constexpr std::array<T, Size> adjust_tile_array(std::span<const T, Size> array, int tile_adj, int palette_num) noexcept
-{
-   GBA_ASSERT(palette_num >= 0 && palette_num < 16);
-   std::array<T, Size> to_ret;
-   for (std::size_t i = 0; i < Size; ++i) {
-      to_ret[i] = (array[i] + tile_adj) | (palette_num << 12);
-   }
-   return to_ret;
-}
-
 struct map_data {
    int width;
    int height;
    int y_offset;
-   std::array<std::uint16_t, 2400> high_priority_tiles;
-   std::array<std::uint16_t, 2400> low_priority_tiles;
+   // These are already rebased to the tileset and palette (see process_map in CMakeLists.txt)
+   const std::uint16_t* high_priority_tiles;
+   const std::uint16_t* low_priority_tiles;
    const std::uint8_t* walkable_map;
    const std::uint8_t* height_map;
    const bool* sprite_high_priority;
@@ -59,14 +49,6 @@ struct map_data {
    {
       return tile_high_priority[x + y * map_data_max_width];
    }
-
-   inline constexpr map_data rebase_map(int tile_adj, int palette_num) const noexcept
-   {
-      const auto high_p = adjust_tile_array(std::span{high_priority_tiles}, tile_adj, palette_num);
-      const auto low_p = adjust_tile_array(std::span{low_priority_tiles}, tile_adj, palette_num);
-      return map_data{
-         width, height, y_offset, high_p, low_p, walkable_map, height_map, sprite_high_priority, tile_high_priority};
-   }
 };
 
 struct enemy_base {
@@ -82,6 +64,8 @@ struct full_map_info {
    std::int8_t base_y;
    const map_data* map;
    std::span<const enemy_base> base_enemies;
+   // chapter * maps_per_chapter + map, to identify the map in telemetry
+   std::uint8_t map_number;
 };
 
 std::span<const char* const> get_map_names(int chapter, const file_save_data& data) noexcept;
@@ -0,0 +1,53 @@
+#include "overlay.hpp"
+
+#include <array>
+
+#ifndef GBA_HOST
+// Defined by devkitARM's linker script
+extern "C" {
+extern std::uint32_t __iwram_overlay_start[];
+extern const std::uint32_t __load_start_iwram0[];
+extern const std::uint32_t __load_stop_iwram0[];
+extern const std::uint32_t __load_start_iwram1[];
+extern const std::uint32_t __load_stop_iwram1[];
+}
+#endif
+
+namespace {
+
+#ifndef GBA_HOST
+struct overlay_range {
+   const std::uint32_t* start;
+   const std::uint32_t* stop;
+};
+
+// Indexed by overlay_id
+const std::array<overlay_range, 2> overlay_ranges{{
+   {__load_start_iwram0, __load_stop_iwram0},
+   {__load_start_iwram1, __load_stop_iwram1},
+}};
+#endif
+
+overlay_id current_overlay = overlay_id::none;
+
+} // anonymous namespace
+
+void load_overlay(overlay_id overlay) noexcept
+{
+   if (overlay == current_overlay || overlay == overlay_id::none) {
+      return;
+   }
+   // The host build has no IWRAM, so the code is always where it's called from
+#ifndef GBA_HOST
+   const auto index = static_cast<std::size_t>(overlay);
+   GBA_ASSERT(index < overlay_ranges.size());
+   const auto [start, stop] = overlay_ranges[index];
+   // A DMA word count of 0 means the maximum, so empty overlays have to be skipped
+   if (start != stop) {
+      gba::dma3_copy(start, stop, __iwram_overlay_start);
+   }
+#endif
+   current_overlay = overlay;
+}
+
+overlay_id loaded_overlay() noexcept { return current_overlay; }
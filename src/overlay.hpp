@@ -0,0 +1,44 @@
+#ifndef OVERLAY_HPP
+#define OVERLAY_HPP
+
+#include "gba.hpp"
+
+#include <cstdint>
+
+// IWRAM code overlays
+// There isn't room in IWRAM for every scene's hot code, so devkitARM's linker script has ten overlay sections
+// (.iwram0 to .iwram9) which all link to the same window of IWRAM and are copied there from ROM on demand
+// Only one is loaded at a time and code in one can't call code in another
+
+// The overlay numbers have to be literals for GBA_IWRAM_OVERLAY_CODE, hence the macros
+// Pathfinding and the map/sprite renderer
+#define BATTLE_OVERLAY 0
+// Save file checksums
+#define MENU_OVERLAY 1
+
+enum struct overlay_id : std::uint8_t {
+   none = 0xFF,
+   battle = BATTLE_OVERLAY,
+   menus = MENU_OVERLAY,
+};
+
+// Copies the overlay into the window unless it's already there
+void load_overlay(overlay_id overlay) noexcept;
+
+overlay_id loaded_overlay() noexcept;
+
+// Loads an overlay and puts back whichever was loaded before when it goes out of scope
+class overlay_scope {
+public:
+   explicit overlay_scope(overlay_id overlay) noexcept : previous{loaded_overlay()} { load_overlay(overlay); }
+
+   overlay_scope(const overlay_scope&) = delete;
+   overlay_scope& operator=(const overlay_scope&) = delete;
+
+   ~overlay_scope() noexcept { load_overlay(previous); }
+
+private:
+   overlay_id previous;
+};
+
+#endif // OVERLAY_HPP
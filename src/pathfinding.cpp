@@ -1,15 +1,18 @@
 #include "pathfinding.hpp"
 
+#include "profiler.hpp"
+
 #include <array>
 
-static_vector<pos, num_squares> find_path(
+GBA_IWRAM_OVERLAY_CODE(BATTLE_OVERLAY) static_vector<pos, num_squares> find_path(
    std::int8_t x,
    std::int8_t y,
    std::int8_t range,
    std::int8_t jump,
    const full_map_info& map_info,
-   std::span<const combatant> enemy_units)
+   std::span<const pos> enemy_units)
 {
+   PROFILE_ZONE(find_path);
    constexpr std::array<pos, 4> offsets{{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
    // also the value to return
    static_vector<pos, num_squares> seen;
@@ -38,7 +41,6 @@ static_vector<pos, num_squares> find_path(
       for (const auto& offset : offsets) {
          const auto i8 = [](const auto& val) { return static_cast<std::int8_t>(val); };
          const auto new_pos = pos{i8(current.x + offset.x), i8(current.y + offset.y)};
-         const auto matches_loc = [&](const auto& unit) { return unit.x == new_pos.x && unit.y == new_pos.y; };
          // If it's out of bound skip it
          if (new_pos.x < 0 || new_pos.y < 0 || new_pos.x >= map_info.map->width || new_pos.y >= map_info.map->height) {
             continue;
@@ -48,7 +50,7 @@ static_vector<pos, num_squares> find_path(
             continue;
          }
          // If there's an enemy unit in the way don't add this location
-         if (std::find_if(enemy_units.begin(), enemy_units.end(), matches_loc) != enemy_units.end()) {
+         if (std::find(enemy_units.begin(), enemy_units.end(), new_pos) != enemy_units.end()) {
             continue;
          }
          // If the jump is too large don't add the location
@@ -2,7 +2,9 @@
 #define PATHFINDING_HPP
 
 #include "data.hpp"
+#include "gba.hpp"
 #include "map_data.hpp"
+#include "overlay.hpp"
 #include "static_vector.hpp"
 
 #include <span>
@@ -47,12 +49,13 @@ struct pos {
 
 inline constexpr auto num_squares = (max_move * 2 + 1) * (max_move * 2 + 1) / 2 + 1;
 
-static_vector<pos, num_squares> find_path(
+// Runs from the battle overlay as ARM code; it's called for every enemy on every turn
+GBA_IWRAM_OVERLAY_CODE(BATTLE_OVERLAY) static_vector<pos, num_squares> find_path(
    std::int8_t x,
    std::int8_t y,
    std::int8_t range,
    std::int8_t jump,
    const full_map_info& map_info,
-   std::span<const combatant> enemy_units);
+   std::span<const pos> enemy_units);
 
 #endif // PATHFINDING_HPP
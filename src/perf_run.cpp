@@ -0,0 +1,117 @@
+#include "perf_run.hpp"
+
+#ifdef PEKMUN2_PERF_RUN
+
+#include "alloc_check.hpp"
+#include "frame_monitor.hpp"
+#include "save_data.hpp"
+#include "stack_monitor.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+struct input_header {
+   std::array<char, 4> magic;
+   std::uint16_t num_steps;
+   std::uint16_t unused;
+};
+
+struct input_step {
+   std::uint16_t frames;
+   std::uint16_t keys;
+};
+
+struct report_header {
+   std::array<char, 4> magic;
+   std::uint32_t frames;
+   std::uint16_t num_scenes;
+   std::uint16_t unused;
+};
+
+struct report_scene {
+   std::uint32_t frames;
+   std::uint32_t late_frames;
+   std::uint32_t worst_lines;
+   std::array<std::uint32_t, frame_monitor::num_buckets> histogram;
+   std::uint32_t stack_bytes;
+};
+
+constexpr int report_size = sizeof(report_header) + frame_monitor::num_scenes * sizeof(report_scene);
+constexpr int max_steps = (perf_run::input_size - sizeof(input_header)) / sizeof(input_step);
+
+static_assert(perf_run::input_offset >= file_slot_offset(num_usable_file_slots));
+static_assert(perf_run::input_offset + perf_run::input_size <= perf_run::report_offset);
+static_assert(perf_run::report_offset + report_size <= save_data_end);
+static_assert(max_steps > 0);
+
+constexpr std::uint16_t all_keys = 0x3FF;
+
+int num_steps = 0;
+int step = 0;
+int frames_left_in_step = 0;
+std::uint16_t step_keys = 0;
+std::uint32_t frames_run = 0;
+
+volatile std::uint8_t* step_loc(int i) noexcept
+{
+   return gba::sram_addr() + perf_run::input_offset + sizeof(input_header) + i * sizeof(input_step);
+}
+
+} // anonymous namespace
+
+namespace perf_run {
+
+void start() noexcept
+{
+   const auto header = sram_read<input_header>(gba::sram_addr() + input_offset);
+   if (header.magic != std::array<char, 4>{'P', 'K', 'I', '1'} || header.num_steps > max_steps) {
+      // The runner reports a run that ends on the first frame as having no input script
+      finish();
+   }
+   num_steps = header.num_steps;
+}
+
+std::uint16_t read_keys() noexcept
+{
+   while (frames_left_in_step == 0) {
+      if (step == num_steps) {
+         finish();
+      }
+      const auto next = sram_read<input_step>(step_loc(step));
+      frames_left_in_step = next.frames;
+      step_keys = next.keys;
+      ++step;
+   }
+   --frames_left_in_step;
+   ++frames_run;
+   return ~step_keys & all_keys;
+}
+
+void finish() noexcept
+{
+   const auto loc = gba::sram_addr() + report_offset;
+   stack_monitor::take_mark(frame_monitor::current_scene());
+   alloc_check::log_report();
+   sram_write(report_header{{'P', 'K', 'R', '2'}, frames_run, frame_monitor::num_scenes, 0}, loc);
+   for (int i = 0; i < frame_monitor::num_scenes; ++i) {
+      const auto scene_id = static_cast<frame_scene>(i);
+      const auto& stats = frame_monitor::stats_for(scene_id);
+      const report_scene scene{stats.frames, stats.late_frames, static_cast<std::uint32_t>(stats.worst_lines),
+         stats.histogram, static_cast<std::uint32_t>(stack_monitor::worst_bytes(scene_id))};
+      sram_write(scene, loc + sizeof(report_header) + i * sizeof(report_scene));
+   }
+#ifdef GBA_HOST
+   std::exit(0);
+#else
+   asm volatile("swi %0" ::"i"(exit_swi));
+   // In case the emulator doesn't stop
+   while (true) {}
+#endif
+}
+
+} // namespace perf_run
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef PERF_RUN_HPP
+#define PERF_RUN_HPP
+
+#include "gba.hpp"
+
+#include <cstdint>
+
+// Scripted runs for the emulator perf check (scripts/perf_check.py), built with PEKMUN2_PERF_RUN defined
+// The keypad is read from an input script the runner puts in SRAM instead of KEYINPUT; when the script runs out the
+// frame monitor's stats are written back to SRAM and the ROM exits the emulator with exit_swi
+// Perf run ROMs are for emulators only: real hardware has nothing at exit_swi
+// Without PEKMUN2_PERF_RUN everything here compiles down to reading KEYINPUT
+namespace perf_run {
+
+// Traps into the emulator's test runner (mgba-rom-test -S); the BIOS only has calls up to 0x2A
+inline constexpr int exit_swi = 0xF0;
+
+// SRAM layout (see scripts/perf_check.py), both in the last file slot, which scenarios must not save to
+// Input script:
+//    char magic[4]        'P', 'K', 'I', '1'
+//    u16 num_steps
+//    u16 unused
+//    followed by num_steps steps of: u16 frames, u16 keys held (a bit per key in KEYINPUT order, set when held)
+// Report, written when the script runs out:
+//    char magic[4]        'P', 'K', 'R', '2'
+//    u32 frames           frames the script ran for
+//    u16 num_scenes
+//    u16 unused
+//    followed by num_scenes times: u32 frames, u32 late_frames, u32 worst_lines, u32 histogram[5],
+//       u32 stack_bytes (see stack_monitor.hpp)
+inline constexpr int input_offset = 0x5C10;
+inline constexpr int input_size = 0x3F0;
+inline constexpr int report_offset = 0x7700;
+
+#ifdef PEKMUN2_PERF_RUN
+
+// Checks the input script is there; call once at boot
+void start() noexcept;
+
+// This frame's keys in the KEYINPUT format; ends the run once the script has run out
+std::uint16_t read_keys() noexcept;
+
+// Writes the report and exits the emulator
+[[noreturn]] void finish() noexcept;
+
+#else
+
+inline void start() noexcept {}
+inline std::uint16_t read_keys() noexcept { return gba::read_keys(); }
+
+#endif
+
+} // namespace perf_run
+
+#endif // PERF_RUN_HPP
@@ -0,0 +1,71 @@
+#ifndef PRNG_HPP
+#define PRNG_HPP
+
+#include "gba.hpp"
+
+#include <cstdint>
+
+// xorshift32: three shifts and xors per number, all native 32-bit Thumb instructions
+// The state is one word so it can be seeded, copied and saved like any other value
+class prng {
+public:
+   // Seeds of 0 are remapped since xorshift would only ever return 0
+   explicit constexpr prng(std::uint32_t seed) noexcept : state{seed != 0 ? seed : 0x9E37'79B9} {}
+
+   constexpr std::uint32_t next() noexcept
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+   }
+
+   // Uniform in [0, bound) for bound <= 65536
+   // Scales the top 16 bits by bound rather than using %, so it's one multiply and a shift with no division
+   // (The bias is at most bound / 65536, which is well under a percent for the ranges used)
+   constexpr std::uint32_t below(std::uint32_t bound) noexcept
+   {
+      GBA_ASSERT(bound <= 0x1'0000);
+      return ((next() >> 16) * bound) >> 16;
+   }
+
+   // Uniform in [min, max]
+   constexpr int between(int min, int max) noexcept
+   {
+      return min + static_cast<int>(below(static_cast<std::uint32_t>(max - min + 1)));
+   }
+
+   constexpr std::uint32_t get_state() const noexcept { return state; }
+
+private:
+   std::uint32_t state;
+};
+
+// Each use of randomness has its own stream so that, for example, adding a cosmetic effect doesn't change the
+// stat rolls of a battle with the same seed
+struct battle_rng {
+   // Every stream is derived from one seed, which is all that needs storing to replay a battle
+   explicit constexpr battle_rng(std::uint32_t seed) noexcept
+      : seed{seed}, stats{derive(seed, 1)}, ai{derive(seed, 2)}, cosmetic{derive(seed, 3)}
+   {}
+
+   std::uint32_t seed;
+   // Enemy stat rolls
+   prng stats;
+   // Enemy decisions
+   prng ai;
+   // Anything that doesn't affect the outcome
+   prng cosmetic;
+
+private:
+   // Hashes the seed with the stream number (splitmix32's finalizer) so nearby seeds give unrelated streams
+   static constexpr std::uint32_t derive(std::uint32_t seed, std::uint32_t stream) noexcept
+   {
+      auto x = seed + stream * 0x9E37'79B9;
+      x = (x ^ (x >> 16)) * 0x85EB'CA6B;
+      x = (x ^ (x >> 13)) * 0xC2B2'AE35;
+      return x ^ (x >> 16);
+   }
+};
+
+#endif // PRNG_HPP
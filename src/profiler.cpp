@@ -0,0 +1,86 @@
+#include "profiler.hpp"
+
+#ifndef NDEBUG
+
+   #include "common_funcs.hpp"
+   #include "debug_layer.hpp"
+   #include "fmt/core.h"
+
+   #include <iterator>
+
+namespace profiler {
+
+std::array<std::uint32_t, num_zones> zone_cycles{};
+
+} // namespace profiler
+
+namespace {
+
+constexpr std::array<const char*, profiler::num_zones> zone_names{
+   "find_path",
+   "update_screen",
+   "scroll_layer",
+   "enemy_ai",
+   "sram_write",
+};
+
+// The frame line and a line per zone, drawn at the top of the debug layer
+constexpr int overlay_rows = profiler::num_zones + 1;
+
+std::array<std::uint32_t, profiler::num_zones> last_zone_cycles{};
+std::uint32_t last_frame_cycles = 0;
+std::uint32_t frame_start = 0;
+bool overlay_visible = false;
+
+void draw_overlay() noexcept
+{
+   const auto draw_line = [](int y, const char* name, std::uint32_t cycles) {
+      // Percent of a frame without a 64-bit multiply
+      const auto percent = cycles / (gba::cycles_per_frame / 100);
+      char buffer[31];
+      const auto end = fmt::format_to_n(buffer, std::size(buffer) - 1, "{: <13}{: >8}{: >4}%", name, cycles, percent);
+      *end.out = '\0';
+      write_at(debug_layer::screen_block, buffer, 0, y);
+   };
+   draw_line(0, "frame", last_frame_cycles);
+   for (int i = 0; i < profiler::num_zones; ++i) {
+      draw_line(i + 1, zone_names[i], last_zone_cycles[i]);
+   }
+}
+
+} // anonymous namespace
+
+namespace profiler {
+
+void start() noexcept
+{
+   frame_start = gba::cycle_count();
+}
+
+void end_frame() noexcept
+{
+   last_frame_cycles = gba::cycle_count() - frame_start;
+   last_zone_cycles = zone_cycles;
+   zone_cycles.fill(0);
+}
+
+void begin_frame(const gba::keypad_status& keypad) noexcept
+{
+   if (keypad.l_held() && keypad.r_held() && keypad.select_pressed()) {
+      overlay_visible = !overlay_visible;
+      if (overlay_visible) {
+         debug_layer::acquire();
+      }
+      else {
+         debug_layer::release(0, overlay_rows);
+      }
+   }
+   if (overlay_visible) {
+      draw_overlay();
+   }
+   frame_start = gba::cycle_count();
+}
+
+} // namespace profiler
+
+#endif
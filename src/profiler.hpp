@@ -0,0 +1,73 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "gba.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Cycle profiler for finding out where frames go on hardware
+// PROFILE_ZONE(name) times the rest of its scope with the TM2/TM3 cycle counter and adds it to that zone's total
+// for the frame; zones nest, so an outer zone's time includes the zones inside it
+// Holding L+R and pressing SELECT toggles an overlay with the last frame's totals, drawn on the debug layer
+// Everything compiles out in release builds
+enum struct profile_zone : std::uint8_t {
+   find_path,
+   update_screen,
+   scroll_layer,
+   enemy_ai,
+   sram_write,
+   count
+};
+
+#ifdef NDEBUG
+   #define PROFILE_ZONE(zone) static_cast<void>(0)
+#else
+   #define PROFILE_ZONE(zone) \
+      const profiler::zone_scope PROFILE_DETAIL_CONCAT(profile_zone_scope_, __LINE__) { profile_zone::zone }
+   #define PROFILE_DETAIL_CONCAT(a, b) PROFILE_DETAIL_CONCAT2(a, b)
+   #define PROFILE_DETAIL_CONCAT2(a, b) a##b
+#endif
+
+namespace profiler {
+
+inline constexpr auto num_zones = static_cast<int>(profile_zone::count);
+
+#ifdef NDEBUG
+
+inline void start() noexcept {}
+inline void end_frame() noexcept {}
+inline void begin_frame(const gba::keypad_status&) noexcept {}
+
+#else
+
+// The zone totals for the frame in progress
+extern std::array<std::uint32_t, num_zones> zone_cycles;
+
+class zone_scope {
+public:
+   explicit zone_scope(profile_zone zone) noexcept : zone{zone}, start{gba::cycle_count()} {}
+
+   zone_scope(const zone_scope&) = delete;
+   zone_scope& operator=(const zone_scope&) = delete;
+
+   ~zone_scope() noexcept { zone_cycles[static_cast<int>(zone)] += gba::cycle_count() - start; }
+
+private:
+   profile_zone zone;
+   std::uint32_t start;
+};
+
+// Call once at boot, after starting the cycle counter
+void start() noexcept;
+
+// wait_vblank_and_update calls these around waiting so the wait isn't counted as part of the frame
+// begin_frame also handles the overlay toggle and draws the overlay (during vblank)
+void end_frame() noexcept;
+void begin_frame(const gba::keypad_status& keypad) noexcept;
+
+#endif
+
+} // namespace profiler
+
+#endif // PROFILER_HPP
@@ -3,6 +3,7 @@
 
 #include "data.hpp"
 #include "gba.hpp"
+#include "profiler.hpp"
 
 #include <fmt/core.h>
 
@@ -10,6 +11,7 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 
 struct global_save_data {
    std::int8_t last_file_select;
@@ -18,10 +20,20 @@ struct global_save_data {
 constexpr std::array<char, 4> file_exists_text{{'P', 'e', 'k', '2'}};
 
 inline constexpr int max_characters = 16;
+// Every item in a file counts towards this, equipped or not; the worst case file only fits in a bank because of
+// it (see max_payload_size in save_format.cpp)
 inline constexpr int max_items = 48;
 
+// Files are serialized into fixed size banks in SRAM (see save_format.hpp)
+// Each file alternates between two banks so an interrupted save leaves the previous one intact
+inline constexpr int num_file_slots = 4;
+inline constexpr int num_file_banks = 2;
+inline constexpr int file_bank_size = 0xF00;
+// The directory of file summaries at the start of SRAM is double-buffered the same way
+inline constexpr int num_directory_banks = 2;
+inline constexpr int directory_bank_size = 0x100;
+
 struct file_save_data {
-   std::array<char, 4> exists_text = file_exists_text;
    bool game_completed = false;
    std::uint16_t enemy_strength = 0;
    std::array<character, max_characters> characters;
@@ -34,10 +46,15 @@ struct file_save_data {
    std::uint64_t money = 0;
 };
 
-struct file_load_data {
-   decltype(file_save_data::file_name) file_name;
-   std::int32_t file_level;
+// What the file select screen shows for a file (see file_directory in save_format.hpp)
+struct file_summary {
    std::uint64_t frame_count;
+   // The sequence number of the file's bank this was made from
+   std::uint32_t sequence;
+   std::int32_t file_level;
+   decltype(file_save_data::file_name) file_name;
+   bool exists;
+   std::uint8_t chapter;
 };
 
 // SRAM can only be accessed with 8-bit reads/writes so we need specialized function for access
@@ -67,27 +84,72 @@ inline void sram_write(const T& val, volatile std::uint8_t* loc) noexcept
    }
 }
 
-inline volatile std::uint8_t* file_save_loc(int file_no) noexcept
+inline void sram_read_bytes(std::span<std::uint8_t> data, const volatile std::uint8_t* loc) noexcept
+{
+   for (int i = 0; i < static_cast<int>(data.size()); ++i) {
+      data[i] = loc[i];
+   }
+}
+
+inline void sram_write_bytes(std::span<const std::uint8_t> data, volatile std::uint8_t* loc) noexcept
 {
-   return gba::sram_addr() + sizeof(global_save_data) + file_no * sizeof(file_save_data);
+   PROFILE_ZONE(sram_write);
+   for (int i = 0; i < static_cast<int>(data.size()); ++i) {
+      loc[i] = data[i];
+   }
 }
 
-inline bool file_exists(int file_no) noexcept
+// Only writes the bytes of data that differ from previous, which must be what's currently stored at loc
+// SRAM writes are slow so this makes the cost scale with how much has changed
+// Returns the number of bytes written
+inline int sram_write_changed(
+   std::span<const std::uint8_t> data, std::span<const std::uint8_t> previous, volatile std::uint8_t* loc) noexcept
 {
-   const auto base_addr = file_save_loc(file_no);
-   const auto exists_offset = offsetof(file_save_data, exists_text);
-   const auto header = sram_read<decltype(file_save_data::exists_text)>(base_addr + exists_offset);
-   return header == file_exists_text;
+   PROFILE_ZONE(sram_write);
+   GBA_ASSERT(data.size() <= previous.size());
+   int bytes_written = 0;
+   for (int i = 0; i < static_cast<int>(data.size()); ++i) {
+      if (data[i] != previous[i]) {
+         loc[i] = data[i];
+         ++bytes_written;
+      }
+   }
+   return bytes_written;
 }
 
-inline file_load_data get_file_load_data(int file_no) noexcept
+// Where file_no's banks start, as an offset into SRAM
+constexpr int file_slot_offset(int file_no) noexcept
 {
-   file_load_data to_ret;
-   const auto base_addr = file_save_loc(file_no);
-   sram_read(to_ret.file_name, base_addr + offsetof(file_save_data, file_name));
-   sram_read(to_ret.file_level, base_addr + offsetof(file_save_data, file_level));
-   sram_read(to_ret.frame_count, base_addr + offsetof(file_save_data, frame_count));
-   return to_ret;
+   return sizeof(global_save_data) + num_directory_banks * directory_bank_size
+        + file_no * num_file_banks * file_bank_size;
+}
+
+// Builds that keep debug data in SRAM put it in the last slot (see battle_telemetry.cpp and perf_run.cpp), so files
+// can't be saved there
+#if defined(PEKMUN2_TELEMETRY_SRAM) || defined(PEKMUN2_PERF_RUN)
+inline constexpr int num_usable_file_slots = num_file_slots - 1;
+#else
+inline constexpr int num_usable_file_slots = num_file_slots;
+#endif
+
+inline volatile std::uint8_t* directory_bank_loc(int bank) noexcept
+{
+   return gba::sram_addr() + sizeof(global_save_data) + bank * directory_bank_size;
+}
+
+inline volatile std::uint8_t* file_bank_loc(int file_no, int bank) noexcept
+{
+   return gba::sram_addr() + file_slot_offset(file_no) + bank * file_bank_size;
+}
+
+// Items in the inventory plus items equipped by characters, which must not be more than max_items
+inline int count_items(const file_save_data& data) noexcept
+{
+   int count = 0;
+   for (const auto& char_ : data.characters) {
+      count += std::count_if(char_.equips.begin(), char_.equips.end(), [](const item& equip) { return equip.exists; });
+   }
+   return count + std::count_if(data.items.begin(), data.items.end(), [](const item& item_) { return item_.exists; });
 }
 
 inline std::array<char, 14> frames_to_time(std::uint64_t frame_count) noexcept
@@ -106,8 +168,11 @@ inline global_save_data get_global_save_data() noexcept { return sram_read<globa
 
 inline void write_global_save_data(const global_save_data& data) noexcept { sram_write(data, gba::sram_addr()); }
 
+// Where the save files end; SRAM after this holds debug data (the log, see gba_log.hpp)
+inline constexpr int save_data_end = file_slot_offset(num_file_slots);
+
 // Ensure there's enough SRAM to save everything
 // (Using SRAM larger than 0x7FFF requires special commands and stuff)
-static_assert(sizeof(global_save_data) + 4 * sizeof(file_save_data) <= 0x7FFF);
+static_assert(save_data_end <= 0x7FFF);
 
 #endif // SAVE_DATA_HPP
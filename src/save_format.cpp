@@ -0,0 +1,663 @@
+#include "save_format.hpp"
+
+#include "crc16.hpp"
+#include "gba_log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+namespace {
+
+// If anything doesn't fit the writer is marked as overflowed and the rest is dropped
+class save_writer {
+public:
+   explicit save_writer(std::span<std::uint8_t> buffer) noexcept : buffer{buffer} {}
+
+   void write_byte(std::uint8_t value) noexcept
+   {
+      bits_used = 8;
+      put(value);
+   }
+
+   void write_varint(std::uint64_t value) noexcept
+   {
+      while (value >= 0x80) {
+         write_byte((value & 0x7F) | 0x80);
+         value >>= 7;
+      }
+      write_byte(value);
+   }
+
+   void write_signed_varint(std::int64_t value) noexcept
+   {
+      // Zigzag encode so small negative numbers stay small
+      write_varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+   }
+
+   // Bits are packed LSB first into a byte that's shared by consecutive write_bits calls
+   // Any other write starts a new byte
+   void write_bits(std::uint32_t value, int num_bits) noexcept
+   {
+      GBA_ASSERT(num_bits <= 32);
+      for (int i = 0; i < num_bits; ++i) {
+         if (bits_used == 8) {
+            bits_loc = pos;
+            put(0);
+            bits_used = 0;
+         }
+         if (!overflowed_ && ((value >> i) & 1)) {
+            buffer[bits_loc] |= 1 << bits_used;
+         }
+         ++bits_used;
+      }
+   }
+
+   template<std::size_t N>
+   void write_string(const std::array<char, N>& str) noexcept
+   {
+      const auto length = strnlen(str.data(), N);
+      write_varint(length);
+      for (std::size_t i = 0; i < length; ++i) {
+         write_byte(str[i]);
+      }
+   }
+
+   int size() const noexcept { return pos; }
+
+   bool overflowed() const noexcept { return overflowed_; }
+
+private:
+   void put(std::uint8_t value) noexcept
+   {
+      if (pos == static_cast<int>(buffer.size())) {
+         overflowed_ = true;
+         return;
+      }
+      buffer[pos] = value;
+      ++pos;
+   }
+
+   std::span<std::uint8_t> buffer;
+   int pos = 0;
+   int bits_loc = 0;
+   int bits_used = 8;
+   bool overflowed_ = false;
+};
+
+// Mirrors save_writer; reading past the end gives zeros and marks the reader as failed
+class save_reader {
+public:
+   save_reader(const volatile std::uint8_t* data, int size) noexcept : data{data}, size{size} {}
+
+   std::uint8_t read_byte() noexcept
+   {
+      bits_used = 8;
+      return get();
+   }
+
+   std::uint64_t read_varint() noexcept
+   {
+      std::uint64_t value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+         const auto byte = read_byte();
+         value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+         if (!(byte & 0x80)) {
+            return value;
+         }
+      }
+      failed_ = true;
+      return value;
+   }
+
+   std::int64_t read_signed_varint() noexcept
+   {
+      const auto value = read_varint();
+      return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+   }
+
+   // For values that are 32-bit in memory; anything out of range is clamped
+   std::int32_t read_stat() noexcept { return std::clamp<std::int64_t>(read_signed_varint(), stat_min, stat_max); }
+
+   std::uint32_t read_bits(int num_bits) noexcept
+   {
+      GBA_ASSERT(num_bits <= 32);
+      std::uint32_t value = 0;
+      for (int i = 0; i < num_bits; ++i) {
+         if (bits_used == 8) {
+            bits = get();
+            bits_used = 0;
+         }
+         value |= static_cast<std::uint32_t>((bits >> bits_used) & 1) << i;
+         ++bits_used;
+      }
+      return value;
+   }
+
+   // For runs of bits longer than read_bits can return
+   void skip_bits(int num_bits) noexcept
+   {
+      for (; num_bits > 32; num_bits -= 32) {
+         read_bits(32);
+      }
+      read_bits(num_bits);
+   }
+
+   template<std::size_t N>
+   void read_string(std::array<char, N>& str) noexcept
+   {
+      const auto length = read_varint();
+      std::fill(str.begin(), str.end(), '\0');
+      for (std::uint64_t i = 0; i < length; ++i) {
+         const char c = read_byte();
+         if (i < N) {
+            str[i] = c;
+         }
+      }
+   }
+
+   bool failed() const noexcept { return failed_; }
+
+private:
+   std::uint8_t get() noexcept
+   {
+      if (pos == size) {
+         failed_ = true;
+         return 0;
+      }
+      const auto value = data[pos];
+      ++pos;
+      return value;
+   }
+
+   const volatile std::uint8_t* data;
+   int size;
+   int pos = 0;
+   std::uint8_t bits = 0;
+   int bits_used = 8;
+   bool failed_ = false;
+};
+
+struct file_header {
+   std::array<char, 4> magic;
+   std::uint16_t crc;
+   std::uint8_t version;
+   int payload_size;
+   std::uint32_t sequence;
+
+   // Files from newer versions of the game can't be read
+   bool valid() const noexcept
+   {
+      return magic == file_exists_text && version <= save_format_version
+          && payload_size <= file_bank_size - file_header_size;
+   }
+
+   // The number of bytes used in the bank
+   int size() const noexcept { return file_header_size + payload_size; }
+};
+
+// The CRC covers everything after itself
+constexpr int crc_start = 6;
+
+file_header read_header(const volatile std::uint8_t* loc) noexcept
+{
+   file_header to_ret;
+   for (int i = 0; i < 4; ++i) {
+      to_ret.magic[i] = loc[i];
+   }
+   to_ret.crc = loc[4] | (loc[5] << 8);
+   to_ret.version = loc[6];
+   to_ret.payload_size = loc[7] | (loc[8] << 8);
+   to_ret.sequence = loc[9] | (loc[10] << 8) | (loc[11] << 16) | (loc[12] << 24);
+   return to_ret;
+}
+
+// Checks the CRC a piece at a time rather than copying the whole bank out of SRAM
+bool crc_matches(const volatile std::uint8_t* loc, const file_header& header) noexcept
+{
+   std::array<std::uint8_t, 64> buffer;
+   std::uint16_t crc = 0xFFFF;
+   for (int i = crc_start; i < header.size(); i += buffer.size()) {
+      const auto piece = std::span{buffer}.first(std::min<int>(buffer.size(), header.size() - i));
+      sram_read_bytes(piece, loc + i);
+      crc = crc16(piece, crc);
+   }
+   return crc == header.crc;
+}
+
+// Reads bank into the cache if it holds a valid file, whatever its sequence number, so the next save to it only writes
+// what changed
+void cache_bank(int file_no, int bank, file_cache& cache) noexcept
+{
+   const auto loc = file_bank_loc(file_no, bank);
+   const auto header = read_header(loc);
+   cache.bank_known[bank] = false;
+   if (!header.valid()) {
+      return;
+   }
+   auto& image = cache.banks[bank];
+   std::fill(image.begin(), image.end(), 0);
+   sram_read_bytes(std::span{image}.first(header.size()), loc);
+   cache.bank_known[bank] = crc16(std::span{image}.subspan(crc_start, header.size() - crc_start)) == header.crc;
+}
+
+struct bank_info {
+   // -1 if there's no valid bank
+   int bank;
+   file_header header;
+};
+
+// Finds the bank with the highest sequence number that has a valid header and CRC
+bank_info find_active_bank(int file_no) noexcept
+{
+   bank_info to_ret{-1, {}};
+   for (int bank = 0; bank < num_file_banks; ++bank) {
+      const auto loc = file_bank_loc(file_no, bank);
+      const auto header = read_header(loc);
+      if (
+         header.valid() && (to_ret.bank == -1 || header.sequence > to_ret.header.sequence)
+         && crc_matches(loc, header)) {
+         to_ret = {bank, header};
+      }
+   }
+   return to_ret;
+}
+
+// Payload layout (version 2):
+//    file_name, file_level, frame_count
+//    bits: game_completed, which characters exist, which items exist
+//    chapter, chapter_progress, enemy_strength, money
+//    each existing character followed by each existing item
+// Characters and items that don't exist aren't stored at all
+// Everything in file_summary is near the start so the directory can be rebuilt without reading it all
+//
+// When the format changes bump save_format_version and check the version when reading so files
+// from older versions are converted (see read_character) or leave the new fields at their defaults
+// (data starts out value initialized)
+
+// Worst case sizes, with every integer at its longest varint and every string full
+constexpr int max_varint_size(int bits) noexcept { return (bits + 6) / 7; }
+
+template<std::size_t N>
+constexpr int max_string_size(const std::array<char, N>&) noexcept
+{
+   return max_varint_size(std::bit_width(N)) + N;
+}
+
+constexpr int max_item_size = 3 + 8 * max_varint_size(32);
+// Not counting equipment, which is part of max_items
+constexpr int max_character_size = 1 + 1 + sizeof(base_stats) + max_string_size(character{}.name)
+                                 + 12 * max_varint_size(32) + 1;
+constexpr int max_payload_size = max_string_size(file_save_data{}.file_name) + max_varint_size(32)
+                               + max_varint_size(64) + (1 + max_characters + max_items + 7) / 8 + 2
+                               + max_varint_size(16) + max_varint_size(64) + max_characters * max_character_size
+                               + max_items * max_item_size;
+static_assert(max_payload_size <= file_bank_size - file_header_size, "A full file must always fit in a bank");
+
+void write_item(save_writer& writer, const item& item) noexcept
+{
+   writer.write_byte(item.item_name);
+   writer.write_byte(item.move);
+   writer.write_byte(item.jump);
+   writer.write_signed_varint(item.hp);
+   writer.write_signed_varint(item.mp);
+   for (const auto stat : {item.attack, item.defense, item.m_attack, item.m_defense, item.speed, item.hit}) {
+      writer.write_signed_varint(stat);
+   }
+}
+
+void read_item(save_reader& reader, item& item) noexcept
+{
+   item.exists = true;
+   item.item_name = reader.read_byte();
+   item.move = reader.read_byte();
+   item.jump = reader.read_byte();
+   item.hp = reader.read_stat();
+   item.mp = reader.read_stat();
+   for (auto stat : {&item.attack, &item.defense, &item.m_attack, &item.m_defense, &item.speed, &item.hit}) {
+      *stat = reader.read_stat();
+   }
+}
+
+void write_character(save_writer& writer, const character& char_) noexcept
+{
+   writer.write_bits(char_.deployed, 1);
+   for (const auto& equip : char_.equips) {
+      writer.write_bits(equip.exists, 1);
+   }
+   writer.write_byte(char_.class_);
+   const auto& bases = char_.bases;
+   for (const auto base : {bases.hp, bases.mp, bases.attack, bases.defense, bases.m_attack, bases.m_defense}) {
+      writer.write_byte(base);
+   }
+   writer.write_byte(bases.speed);
+   writer.write_byte(bases.hit);
+   writer.write_byte(bases.move);
+   writer.write_byte(bases.jump);
+   writer.write_string(char_.name);
+   writer.write_signed_varint(char_.level);
+   for (const auto stat : {char_.hp, char_.max_hp, char_.mp, char_.max_mp}) {
+      writer.write_signed_varint(stat);
+   }
+   writer.write_byte(char_.hp_mp_shift);
+   for (const auto stat : {char_.attack, char_.defense, char_.m_attack, char_.m_defense, char_.speed, char_.hit}) {
+      writer.write_signed_varint(stat);
+   }
+   writer.write_signed_varint(char_.exp);
+   for (const auto& equip : char_.equips) {
+      if (equip.exists) {
+         write_item(writer, equip);
+      }
+   }
+}
+
+void read_character(save_reader& reader, std::uint8_t version, character& char_) noexcept
+{
+   char_.exists = true;
+   char_.deployed = reader.read_bits(1);
+   std::array<bool, 4> equips_exist;
+   for (auto& exists : equips_exist) {
+      exists = reader.read_bits(1);
+   }
+   char_.class_ = reader.read_byte();
+   auto& bases = char_.bases;
+   for (auto base : {&bases.hp, &bases.mp, &bases.attack, &bases.defense, &bases.m_attack, &bases.m_defense}) {
+      *base = reader.read_byte();
+   }
+   bases.speed = reader.read_byte();
+   bases.hit = reader.read_byte();
+   bases.move = reader.read_byte();
+   bases.jump = reader.read_byte();
+   reader.read_string(char_.name);
+   char_.level = reader.read_stat();
+   if (version >= 2) {
+      for (auto stat : {&char_.hp, &char_.max_hp, &char_.mp, &char_.max_mp}) {
+         *stat = reader.read_stat();
+      }
+      char_.hp_mp_shift = reader.read_byte();
+   }
+   else {
+      // Version 1 stored HP/MP unscaled as 64-bit values
+      std::array<std::int64_t, 4> hp_mp;
+      for (auto& value : hp_mp) {
+         value = reader.read_signed_varint();
+      }
+      char_.hp_mp_shift = hp_mp_shift_for(std::max(hp_mp[1], hp_mp[3]));
+      const std::array stats{&char_.hp, &char_.max_hp, &char_.mp, &char_.max_mp};
+      for (int i = 0; i < 4; ++i) {
+         *stats[i] = std::clamp<std::int64_t>(hp_mp[i] >> char_.hp_mp_shift, stat_min, stat_max);
+      }
+   }
+   for (auto stat : {&char_.attack, &char_.defense, &char_.m_attack, &char_.m_defense, &char_.speed, &char_.hit}) {
+      *stat = reader.read_stat();
+   }
+   char_.exp = reader.read_stat();
+   for (int i = 0; i < 4; ++i) {
+      if (equips_exist[i]) {
+         read_item(reader, char_.equips[i]);
+      }
+   }
+}
+
+void write_payload(save_writer& writer, const file_save_data& data) noexcept
+{
+   writer.write_string(data.file_name);
+   writer.write_signed_varint(data.file_level);
+   writer.write_varint(data.frame_count);
+   writer.write_bits(data.game_completed, 1);
+   for (const auto& char_ : data.characters) {
+      writer.write_bits(char_.exists, 1);
+   }
+   for (const auto& item : data.items) {
+      writer.write_bits(item.exists, 1);
+   }
+   writer.write_byte(data.chapter);
+   writer.write_byte(data.chapter_progress);
+   writer.write_varint(data.enemy_strength);
+   writer.write_varint(data.money);
+   for (const auto& char_ : data.characters) {
+      if (char_.exists) {
+         write_character(writer, char_);
+      }
+   }
+   for (const auto& item : data.items) {
+      if (item.exists) {
+         write_item(writer, item);
+      }
+   }
+}
+
+void read_payload(save_reader& reader, std::uint8_t version, file_save_data& data) noexcept
+{
+   reader.read_string(data.file_name);
+   data.file_level = reader.read_stat();
+   data.frame_count = reader.read_varint();
+   data.game_completed = reader.read_bits(1);
+   for (auto& char_ : data.characters) {
+      char_.exists = reader.read_bits(1);
+   }
+   for (auto& item : data.items) {
+      item.exists = reader.read_bits(1);
+   }
+   data.chapter = reader.read_byte();
+   data.chapter_progress = reader.read_byte();
+   data.enemy_strength = reader.read_varint();
+   data.money = reader.read_varint();
+   for (auto& char_ : data.characters) {
+      if (char_.exists) {
+         read_character(reader, version, char_);
+      }
+   }
+   for (auto& item : data.items) {
+      if (item.exists) {
+         read_item(reader, item);
+      }
+   }
+}
+
+// Returns the number of bytes used or -1 if the file doesn't fit in a bank
+// The rest of image is zeroed
+int serialize_file(const file_save_data& data, std::uint32_t sequence, file_image& image) noexcept
+{
+   GBA_ASSERT(count_items(data) <= max_items);
+   std::fill(image.begin(), image.end(), 0);
+   save_writer writer{std::span{image}.subspan(file_header_size)};
+   write_payload(writer, data);
+   if (writer.overflowed()) {
+      return -1;
+   }
+   std::copy(file_exists_text.begin(), file_exists_text.end(), image.begin());
+   image[6] = save_format_version;
+   image[7] = writer.size() & 0xFF;
+   image[8] = writer.size() >> 8;
+   for (int i = 0; i < 4; ++i) {
+      image[9 + i] = sequence >> (i * 8);
+   }
+   const auto size = file_header_size + writer.size();
+   const auto crc = crc16(std::span{image}.subspan(crc_start, size - crc_start));
+   image[4] = crc & 0xFF;
+   image[5] = crc >> 8;
+   return size;
+}
+
+GBA_EWRAM_DATA file_image scratch_image;
+// Files are read into this so a bad payload doesn't touch the caller's data (it's too large for the stack)
+GBA_EWRAM_DATA file_save_data scratch_data;
+
+file_summary summarize(const file_save_data& data, std::uint32_t sequence) noexcept
+{
+   return {data.frame_count, sequence, data.file_level, data.file_name, true, data.chapter};
+}
+
+// Reads the summary straight from the start of the file's payload
+file_summary read_summary(int file_no) noexcept
+{
+   const auto active = find_active_bank(file_no);
+   if (active.bank == -1) {
+      return file_summary{};
+   }
+   save_reader reader{file_bank_loc(file_no, active.bank) + file_header_size, active.header.payload_size};
+   file_summary to_ret;
+   to_ret.exists = true;
+   to_ret.sequence = active.header.sequence;
+   reader.read_string(to_ret.file_name);
+   to_ret.file_level = reader.read_stat();
+   to_ret.frame_count = reader.read_varint();
+   reader.skip_bits(1 + max_characters + max_items);
+   to_ret.chapter = reader.read_byte();
+   return to_ret;
+}
+
+struct directory_bank {
+   std::array<char, 4> magic;
+   std::uint16_t crc;
+   std::uint32_t sequence;
+   file_directory files;
+};
+static_assert(sizeof(directory_bank) <= directory_bank_size);
+
+// Like the files the CRC covers everything after itself
+std::uint16_t directory_crc(const directory_bank& dir) noexcept
+{
+   const auto bytes = reinterpret_cast<const std::uint8_t*>(&dir);
+   constexpr auto start = offsetof(directory_bank, sequence);
+   return crc16({bytes + start, sizeof(directory_bank) - start});
+}
+
+struct directory_info {
+   // -1 if there's no valid bank
+   int bank;
+   directory_bank dir;
+};
+
+directory_info read_active_directory() noexcept
+{
+   directory_info to_ret{-1, {}};
+   for (int bank = 0; bank < num_directory_banks; ++bank) {
+      const auto dir = sram_read<directory_bank>(directory_bank_loc(bank));
+      if (
+         dir.magic == file_exists_text && (to_ret.bank == -1 || dir.sequence > to_ret.dir.sequence)
+         && directory_crc(dir) == dir.crc) {
+         to_ret = {bank, dir};
+      }
+   }
+   return to_ret;
+}
+
+// Writes files to the inactive bank so the directory is only replaced once it's completely written
+void write_directory(const directory_info& active, const file_directory& files) noexcept
+{
+   directory_bank dir{file_exists_text, 0, active.bank == -1 ? 0 : active.dir.sequence + 1, files};
+   dir.crc = directory_crc(dir);
+   sram_write(dir, directory_bank_loc(active.bank == -1 ? 0 : (active.bank + 1) % num_directory_banks));
+}
+
+// For when the directory is missing or corrupt (such as the first time the game is run)
+file_directory rebuild_directory() noexcept
+{
+   file_directory to_ret;
+   for (int i = 0; i < num_file_slots; ++i) {
+      to_ret[i] = read_summary(i);
+   }
+   return to_ret;
+}
+
+void update_directory(int file_no, const file_summary& summary) noexcept
+{
+   const auto active = read_active_directory();
+   auto files = active.bank == -1 ? rebuild_directory() : active.dir.files;
+   files[file_no] = summary;
+   write_directory(active, files);
+}
+
+} // anonymous namespace
+
+int save_file(int file_no, const file_save_data& data, file_cache& cache) noexcept
+{
+   GBA_ASSERT(file_no < num_usable_file_slots);
+   if (cache.file_no != file_no) {
+      // Nothing is cached for this file yet; the sequence has to continue from the existing file
+      const auto active = find_active_bank(file_no);
+      cache.file_no = file_no;
+      cache.active_bank = active.bank == -1 ? num_file_banks - 1 : active.bank;
+      cache.sequence = active.bank == -1 ? 0 : active.header.sequence;
+      std::fill(cache.bank_known.begin(), cache.bank_known.end(), false);
+      // Reading the bank about to be written is cheaper than rewriting all of it
+      cache_bank(file_no, (cache.active_bank + 1) % num_file_banks, cache);
+   }
+
+   const auto bank = (cache.active_bank + 1) % num_file_banks;
+   const auto size = serialize_file(data, cache.sequence + 1, scratch_image);
+   if (size == -1) {
+      GBA_LOG(error, "save_file: file {} too large", file_no);
+      return -1;
+   }
+
+   const auto loc = file_bank_loc(file_no, bank);
+   const auto& previous = cache.banks[bank];
+   const int previous_size = cache.bank_known[bank] ? read_header(previous.data()).size() : 0;
+   // Writes [start, end), only writing the bytes that changed where what's in SRAM is known
+   const auto write_range = [&](int start, int end) {
+      const auto known_end = std::clamp(previous_size, start, end);
+      sram_write_bytes(std::span{scratch_image}.subspan(known_end, end - known_end), loc + known_end);
+      const auto changed = sram_write_changed(
+         std::span{scratch_image}.subspan(start, known_end - start), std::span{previous}.subspan(start), loc + start);
+      return changed + (end - known_end);
+   };
+   // The header goes last so an interrupted save is less likely to leave a valid looking header
+   // (the CRC would catch it regardless)
+   const auto bytes_written = write_range(file_header_size, size) + write_range(0, file_header_size);
+
+   cache.banks[bank] = scratch_image;
+   cache.bank_known[bank] = true;
+   cache.active_bank = bank;
+   cache.sequence += 1;
+   update_directory(file_no, summarize(data, cache.sequence));
+   return bytes_written;
+}
+
+bool load_file(int file_no, file_save_data& data, file_cache& cache) noexcept
+{
+   const auto active = find_active_bank(file_no);
+   if (active.bank == -1) {
+      return false;
+   }
+   cache.file_no = file_no;
+   cache.active_bank = active.bank;
+   cache.sequence = active.header.sequence;
+   // The inactive bank too, since the next save goes to it
+   for (int bank = 0; bank < num_file_banks; ++bank) {
+      cache_bank(file_no, bank, cache);
+   }
+   const auto& image = cache.banks[active.bank];
+   GBA_ASSERT(cache.bank_known[active.bank]);
+
+   save_reader reader{image.data() + file_header_size, active.header.payload_size};
+   scratch_data = file_save_data{};
+   read_payload(reader, active.header.version, scratch_data);
+   if (reader.failed()) {
+      GBA_LOG(error, "load_file: file {} bad payload", file_no);
+      cache.file_no = -1;
+      return false;
+   }
+   data = scratch_data;
+   // The directory can be behind if a save was interrupted after the file was written
+   const auto directory = read_active_directory();
+   if (directory.bank == -1 || directory.dir.files[file_no].sequence != cache.sequence) {
+      update_directory(file_no, summarize(data, cache.sequence));
+   }
+   return true;
+}
+
+file_directory read_file_directory() noexcept
+{
+   const auto active = read_active_directory();
+   if (active.bank != -1) {
+      return active.dir.files;
+   }
+   const auto files = rebuild_directory();
+   write_directory(active, files);
+   return files;
+}
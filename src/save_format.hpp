@@ -0,0 +1,54 @@
+#ifndef SAVE_FORMAT_HPP
+#define SAVE_FORMAT_HPP
+
+#include "save_data.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Files are stored in SRAM in a compact format rather than as file_save_data's in-memory layout
+// Each file has two banks which are written alternately; each bank starts with a header of:
+//    char magic[4]          file_exists_text
+//    u16 crc                CRC16 of everything after it (the rest of the header and the payload)
+//    u8 version             the version of the format the file was written with
+//    u16 payload_size
+//    u32 sequence           incremented on every save; the valid bank with the highest one is used
+// Followed by the payload (see save_format.cpp for the fields)
+// Integers are stored as LEB128 varints (zigzag encoded if signed) and flags are packed into bits
+
+// 1: initial version
+// 2: HP/MP are 32-bit with a shift (see character::hp_mp_shift)
+inline constexpr std::uint8_t save_format_version = 2;
+inline constexpr int file_header_size = 13;
+
+// The serialized form of a file, header included
+using file_image = std::array<std::uint8_t, file_bank_size>;
+
+// A copy of what's in the banks of the last file loaded or saved
+// Saving to that file again only writes the bytes that changed
+struct file_cache {
+   int file_no = -1;
+   int active_bank;
+   std::uint32_t sequence;
+   std::array<file_image, num_file_banks> banks;
+   // Whether banks[i] matches what's in SRAM
+   std::array<bool, num_file_banks> bank_known;
+};
+
+// Writes data to the inactive bank of file_no and makes it the active one
+// Returns the number of bytes written to SRAM or -1 if the file doesn't fit in a bank
+int save_file(int file_no, const file_save_data& data, file_cache& cache) noexcept;
+
+// Loads the newest valid bank of file_no
+// Files written by older versions are migrated; returns false, leaving data as it was, if there's no valid bank or its
+// payload can't be read
+bool load_file(int file_no, file_save_data& data, file_cache& cache) noexcept;
+
+// A summary of every file is kept at the start of SRAM so the file select screen only reads one small block
+// It's double-buffered like the files (with a CRC and sequence number) and rewritten after every save
+using file_directory = std::array<file_summary, num_file_slots>;
+
+// If the directory is missing or corrupt it's rebuilt from the files
+file_directory read_file_directory() noexcept;
+
+#endif // SAVE_FORMAT_HPP
@@ -0,0 +1,33 @@
+#include "scene_arena.hpp"
+
+#include <array>
+
+namespace {
+
+// In .sbss so the pool doesn't take up space in the ROM
+GBA_EWRAM_BSS alignas(4) std::array<std::byte, 0x1'0000> ewram_pool;
+// Ordinary zero-initialized globals go in IWRAM
+alignas(4) std::array<std::byte, 0x1000> iwram_pool;
+
+constinit arena ewram_arena{ewram_pool.data(), ewram_pool.size()};
+constinit arena iwram_arena{iwram_pool.data(), iwram_pool.size()};
+
+} // anonymous namespace
+
+arena& scene_arena(memory_hint hint) noexcept
+{
+   return hint == memory_hint::iwram ? iwram_arena : ewram_arena;
+}
+
+void* scene_allocate(std::size_t size, std::size_t alignment, memory_hint hint) noexcept
+{
+   if (hint == memory_hint::iwram) {
+      if (const auto loc = iwram_arena.allocate(size, alignment)) {
+         return loc;
+      }
+   }
+   const auto loc = ewram_arena.allocate(size, alignment);
+   // The pools are sized for the biggest scene; running out is a bug
+   GBA_ASSERT(loc != nullptr);
+   return loc;
+}
@@ -0,0 +1,99 @@
+#ifndef SCENE_ARENA_HPP
+#define SCENE_ARENA_HPP
+
+#include "gba.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Big buffers that only live as long as a scene (e.g. a battle) are allocated from here instead of the stack
+// The stack is in IWRAM along with hot code and data, so large cold buffers should go in EWRAM
+enum struct memory_hint {
+   // 256 KB but 16-bit with wait states; for large or rarely touched buffers
+   ewram,
+   // 32 KB of fast 32-bit memory; for small buffers read every frame (falls back to EWRAM once full)
+   iwram
+};
+
+// A bump allocator over a fixed pool; everything allocated after a mark is freed by releasing it
+class arena {
+public:
+   constexpr arena(std::byte* pool, std::size_t pool_size) noexcept : pool{pool}, pool_size{pool_size} {}
+
+   // Returns nullptr if there isn't room
+   void* allocate(std::size_t size, std::size_t alignment) noexcept
+   {
+      const auto start = (used + alignment - 1) & ~(alignment - 1);
+      if (start + size > pool_size) {
+         return nullptr;
+      }
+      used = start + size;
+      peak_used = used > peak_used ? used : peak_used;
+      return pool + start;
+   }
+
+   std::size_t mark() const noexcept { return used; }
+
+   void release(std::size_t mark) noexcept
+   {
+      GBA_ASSERT(mark <= used);
+      used = mark;
+   }
+
+   std::size_t size() const noexcept { return pool_size; }
+   std::size_t bytes_used() const noexcept { return used; }
+   // The most that's been in use at once
+   std::size_t peak_bytes_used() const noexcept { return peak_used; }
+
+private:
+   std::byte* pool;
+   std::size_t pool_size;
+   std::size_t used = 0;
+   std::size_t peak_used = 0;
+};
+
+arena& scene_arena(memory_hint hint) noexcept;
+
+// Allocates from the arena for hint, trying EWRAM if an IWRAM allocation doesn't fit
+void* scene_allocate(std::size_t size, std::size_t alignment, memory_hint hint) noexcept;
+
+// Nothing is destructed when a scene ends, so only trivially destructible types can be made
+// With no arguments the object is default-initialized, so arrays aren't zeroed for nothing
+template<typename T, typename... Args>
+T& scene_new(memory_hint hint, Args&&... args) noexcept
+{
+   static_assert(std::is_trivially_destructible_v<T>, "Arena memory is released without running destructors");
+   const auto loc = scene_allocate(sizeof(T), alignof(T), hint);
+   if constexpr (sizeof...(Args) == 0) {
+      return *new (loc) T;
+   }
+   else {
+      return *new (loc) T{std::forward<Args>(args)...};
+   }
+}
+
+// Frees everything allocated from the scene arenas during its lifetime; each scene makes one on entry
+class scene_scope {
+public:
+   scene_scope() noexcept
+      : ewram_mark{scene_arena(memory_hint::ewram).mark()}, iwram_mark{scene_arena(memory_hint::iwram).mark()}
+   {}
+
+   scene_scope(const scene_scope&) = delete;
+   scene_scope& operator=(const scene_scope&) = delete;
+
+   ~scene_scope() noexcept
+   {
+      scene_arena(memory_hint::ewram).release(ewram_mark);
+      scene_arena(memory_hint::iwram).release(iwram_mark);
+   }
+
+private:
+   std::size_t ewram_mark;
+   std::size_t iwram_mark;
+};
+
+#endif // SCENE_ARENA_HPP
@@ -0,0 +1,126 @@
+#include "stack_monitor.hpp"
+
+#ifndef GBA_HOST
+
+#include "common_funcs.hpp"
+#include "debug_layer.hpp"
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+// Defined by devkitARM's linker script; the user stack starts at __sp_usr, just under the IRQ and supervisor stacks
+extern "C" {
+extern std::uint32_t __iwram_overlay_end[];
+extern std::uint32_t __sp_usr[];
+}
+
+namespace {
+
+constexpr std::uint32_t paint = 0xC0DE'57AC;
+constexpr int guard_words = 8;
+
+// Below the frame monitor's rows
+constexpr int readout_first_row = 15;
+constexpr int readout_rows = 4;
+
+std::array<int, frame_monitor::num_scenes> worst{};
+bool readout_visible = false;
+
+volatile std::uint32_t* stack_bottom() noexcept { return __iwram_overlay_end; }
+volatile std::uint32_t* stack_top() noexcept { return __sp_usr; }
+
+// Everything below the stack pointer is free (nothing runs in interrupts), right up to it
+void paint_free_stack() noexcept
+{
+   std::uintptr_t sp;
+   asm volatile("mov %0, sp" : "=r"(sp));
+   const auto end = reinterpret_cast<volatile std::uint32_t*>(sp);
+   for (auto loc = stack_bottom(); loc < end; ++loc) {
+      *loc = paint;
+   }
+}
+
+bool guard_intact() noexcept
+{
+   const auto bottom = stack_bottom();
+   return std::all_of(bottom, bottom + guard_words, [](std::uint32_t word) { return word == paint; });
+}
+
+// How deep the stack has gone since it was last painted; the paint is overwritten from the top down, but big frames
+// can leave some of theirs untouched, so this looks for the lowest word that isn't paint
+int deepest_bytes() noexcept
+{
+   auto loc = stack_bottom();
+   const auto top = stack_top();
+   while (loc < top && *loc == paint) {
+      ++loc;
+   }
+   return (top - loc) * sizeof(std::uint32_t);
+}
+
+void note_depth(frame_scene scene) noexcept
+{
+   GBA_ASSERT(guard_intact());
+   auto& scene_worst = worst[static_cast<int>(scene)];
+   scene_worst = std::max(scene_worst, deepest_bytes());
+}
+
+template<typename... Args>
+void draw_line(int y, fmt::format_string<Args...> format, Args&&... args) noexcept
+{
+   char buffer[31];
+   const auto end = fmt::format_to_n(buffer, std::size(buffer) - 1, format, std::forward<Args>(args)...);
+   *end.out = '\0';
+   write_at(debug_layer::screen_block, buffer, 0, readout_first_row + y);
+}
+
+void draw_readout() noexcept
+{
+   draw_line(0, "{: <7}{: >6} of {: <6}", "stack", "worst", stack_monitor::stack_bytes());
+   for (int i = 0; i < frame_monitor::num_scenes; ++i) {
+      draw_line(i + 1, "{: <7}{: >6}", frame_monitor::scene_name(static_cast<frame_scene>(i)), worst[i]);
+   }
+}
+
+} // anonymous namespace
+
+namespace stack_monitor {
+
+void start() noexcept { paint_free_stack(); }
+
+void take_mark(frame_scene scene) noexcept
+{
+   note_depth(scene);
+   paint_free_stack();
+}
+
+void frame_started(const gba::keypad_status& keypad) noexcept
+{
+   GBA_ASSERT(guard_intact());
+   if (keypad.select_held() && keypad.l_pressed()) {
+      readout_visible = !readout_visible;
+      if (readout_visible) {
+         debug_layer::acquire();
+      }
+      else {
+         debug_layer::release(readout_first_row, readout_rows);
+      }
+   }
+   if (readout_visible) {
+      // Scanning the paint takes a while, so the current scene's mark is only kept up to date while it's shown
+      note_depth(frame_monitor::current_scene());
+      draw_readout();
+   }
+}
+
+int worst_bytes(frame_scene scene) noexcept { return worst[static_cast<int>(scene)]; }
+
+int stack_bytes() noexcept { return (stack_top() - stack_bottom()) * sizeof(std::uint32_t); }
+
+} // namespace stack_monitor
+
+#endif
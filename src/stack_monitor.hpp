@@ -0,0 +1,49 @@
+#ifndef STACK_MONITOR_HPP
+#define STACK_MONITOR_HPP
+
+#include "frame_monitor.hpp"
+#include "gba.hpp"
+
+// Stack high-water marks per scene
+// The stack grows down IWRAM towards the overlay window, with IWRAM code and data below that, and nothing stops it
+// running into them; at boot everything between the overlay window and the stack is painted with a pattern, and how
+// much of the paint has been overwritten is how deep the stack has gone
+// Each scene's mark is taken when the scene ends, after which the free part is painted again
+// The bottom few words are a guard that's checked every frame; finding it overwritten fails an assert, so an
+// overflow shows the crash screen before whatever it overwrote is run or read
+// Holding SELECT and pressing L toggles a readout with each scene's mark on the debug layer
+// The host build has no IWRAM stack, so everything here reads zero there
+namespace stack_monitor {
+
+#ifdef GBA_HOST
+
+inline void start() noexcept {}
+inline void take_mark(frame_scene) noexcept {}
+inline void frame_started(const gba::keypad_status&) noexcept {}
+inline int worst_bytes(frame_scene) noexcept { return 0; }
+inline int stack_bytes() noexcept { return 0; }
+
+#else
+
+// Paints the free part of the stack; call first thing at boot
+void start() noexcept;
+
+// Credits how deep the stack went since the last mark to scene and paints the free part again
+// scene_scope calls it when the scene changes
+void take_mark(frame_scene scene) noexcept;
+
+// wait_vblank_and_update calls this; it checks the guard, handles the readout toggle and draws the readout
+// (during vblank)
+void frame_started(const gba::keypad_status& keypad) noexcept;
+
+// The deepest the stack has gone in the scene as of its last mark, in bytes
+int worst_bytes(frame_scene scene) noexcept;
+
+// How much room the stack has
+int stack_bytes() noexcept;
+
+#endif
+
+} // namespace stack_monitor
+
+#endif // STACK_MONITOR_HPP
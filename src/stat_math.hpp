@@ -0,0 +1,52 @@
+#ifndef STAT_MATH_HPP
+#define STAT_MATH_HPP
+
+#include <cstdint>
+#include <limits>
+
+// Saturating 32-bit arithmetic for stats
+// High enemy strengths can push stats past what fits in 32 bits; clamping instead of widening keeps the
+// battle code in native word sized math rather than libgcc's 64-bit helpers
+inline constexpr std::int32_t stat_max = std::numeric_limits<std::int32_t>::max();
+inline constexpr std::int32_t stat_min = std::numeric_limits<std::int32_t>::min();
+
+constexpr std::int32_t sat_add(std::int32_t lhs, std::int32_t rhs) noexcept
+{
+   std::int32_t result;
+   if (__builtin_add_overflow(lhs, rhs, &result)) {
+      return rhs > 0 ? stat_max : stat_min;
+   }
+   return result;
+}
+
+constexpr std::int32_t sat_sub(std::int32_t lhs, std::int32_t rhs) noexcept
+{
+   std::int32_t result;
+   if (__builtin_sub_overflow(lhs, rhs, &result)) {
+      return rhs < 0 ? stat_max : stat_min;
+   }
+   return result;
+}
+
+constexpr std::int32_t sat_mul(std::int32_t lhs, std::int32_t rhs) noexcept
+{
+   std::int32_t result;
+   if (__builtin_mul_overflow(lhs, rhs, &result)) {
+      return (lhs < 0) != (rhs < 0) ? stat_min : stat_max;
+   }
+   return result;
+}
+
+// For the results of the floating point stat formulas
+constexpr std::int32_t sat_from_double(double value) noexcept
+{
+   if (value >= stat_max) {
+      return stat_max;
+   }
+   if (value <= stat_min) {
+      return stat_min;
+   }
+   return static_cast<std::int32_t>(value);
+}
+
+#endif // STAT_MATH_HPP